@@ -38,6 +38,9 @@ class HaxeCBridge {
 	@:noCompletion
 	static macro function runUserMain()
 		return macro null;
+	@:noCompletion
+	static public macro function gcFreeCall(callback: haxe.macro.Expr, args: Array<haxe.macro.Expr>)
+		return macro $callback($a{args});
 }
 
 	#else
@@ -90,9 +93,14 @@ class HaxeCBridge {
 			args: Array<CType>,
 			ret: CType
 		},
+		variants: Array<FunctionVariant>,
+		lane: Int, // index into laneNames or -1 for the haxe main thread
 		pos: Position,
 	}>();
 
+	// names of the lanes used by @lane functions, lanes are numbered in order of first use
+	static final laneNames = new Array<String>();
+
 	static public function expose(?namespace: String) {
 		var clsRef = Context.getLocalClass(); 
 		var cls = clsRef.get();
@@ -115,6 +123,10 @@ class HaxeCBridge {
 		// add @:keep
 		cls.meta.add(':keep', [], Context.currentPos());
 
+		for (field in fields) {
+			wrapGCFreeCallbacks(field);
+		}
+
 		if (firstRun) {
 			final headerPath = Path.join(['$libName.h']);
 
@@ -264,13 +276,52 @@ class HaxeCBridge {
 
 					var cleanDoc = f.doc != null ? StringTools.trim(removeIndentation(f.doc)) : null;
 					
-					cConversionContext.addTypedFunctionDeclaration(cFuncName, functionDescriptor, cleanDoc, f.pos);
+					var declaration = cConversionContext.addTypedFunctionDeclaration(cFuncName, functionDescriptor, cleanDoc, f.pos);
 
 					inline function getRootCType(t: Type) {
 						var tmpCtx = new CConverterContext({generateTypedef: false, generateTypedefForFunctions: false, generateEnums: true});
 						return tmpCtx.convertType(t, true, true, f.pos);
 					}
 
+					var rootRetCType = getRootCType(functionDescriptor.t);
+
+					if (f.meta.has('internStrings') && f.meta.has('externalThread')) {
+						// the intern cache is only accessed from the haxe thread
+						Context.error('@internStrings cannot be combined with @externalThread', f.pos);
+					}
+
+					var lane = getLaneIndex(f);
+					if (lane >= 0) {
+						for (other in ['externalThread', 'workerThread', 'internStrings']) {
+							if (f.meta.has(other)) {
+								Context.error('@lane cannot be combined with @$other', f.pos);
+							}
+						}
+					}
+
+					if (f.meta.has('workerThread')) {
+						for (other in ['externalThread', 'internStrings', 'batch', 'async']) {
+							if (f.meta.has(other)) {
+								Context.error('@workerThread cannot be combined with @$other', f.pos);
+							}
+						}
+						// the retain table is only accessed from the haxe thread
+						if (rootRetCType.match(Ident('HaxeObject' | 'HaxeString' | 'HaxeStringView')) || isBufferCType(rootRetCType)) {
+							Context.error('@workerThread functions cannot return haxe objects, strings, arrays or bytes because returned values are retained on the haxe thread, return numbers or a structure of numbers instead', f.pos);
+						}
+					}
+
+					var variants = new Array<FunctionVariant>();
+					if (f.meta.has('batch')) {
+						variants.push(createBatchVariant(cConversionContext, declaration, f.pos));
+					}
+					if (f.meta.has('async')) {
+						variants = variants.concat(createAsyncVariants(cConversionContext, declaration, f));
+					}
+					if (rootRetCType.match(Ident('HaxeString'))) {
+						variants.push(createIntoVariant(cConversionContext, declaration, f.pos));
+					}
+
 					var hxcppClass = nativeHxcppName.split('.').join('::');
 
 					// store useful information about this function that we can use when generating the implementation
@@ -285,8 +336,10 @@ class HaxeCBridge {
 						tfunc: tfunc, 
 						rootCTypes: {
 							args: functionDescriptor.args.map(a -> getRootCType(a.v.t)),
-							ret: getRootCType(functionDescriptor.t)
+							ret: rootRetCType
 						},
+						variants: variants,
+						lane: lane,
 						pos: f.pos
 					});
 				default: Context.fatalError('Internal error: Expected function expression', f.pos);
@@ -313,6 +366,67 @@ class HaxeCBridge {
 		}
 	}
 
+	/**
+		Rewrites direct calls to `@gcFreeCallback` arguments of a function field into `HaxeCBridge.gcFreeCall()`
+	**/
+	static function wrapGCFreeCallbacks(field: Field) {
+		switch field.kind {
+			case FFun(fun) if (fun.expr != null):
+				var callbackNames = [for (arg in fun.args) if (arg.meta != null && arg.meta.exists(m -> m.name == 'gcFreeCallback')) arg.name];
+				if (callbackNames.length == 0) return;
+				function wrap(e: Expr): Expr {
+					return switch e.expr {
+						case ECall({expr: EConst(CIdent(name))}, args) if (callbackNames.indexOf(name) != -1):
+							var args = args.map(wrap);
+							macro @:pos(e.pos) HaxeCBridge.gcFreeCall($i{name}, $a{args});
+						default:
+							ExprTools.map(e, wrap);
+					}
+				}
+				fun.expr = wrap(fun.expr);
+			default:
+		}
+	}
+
+	/**
+		Calls a C function pointer in a GC-free zone so other threads can collect while the C code runs
+
+		Arguments are evaluated before entering the zone
+	**/
+	static public macro function gcFreeCall(callback: Expr, args: Array<Expr>) {
+		var pos = Context.currentPos();
+		var functionType = switch Context.follow(Context.typeof(callback)) {
+			case TAbstract(_.get() => {pack: ['cpp'], name: 'Callable'}, [t]): Context.follow(t);
+			default: Context.error('@gcFreeCallback can only be used on cpp.Callable arguments', callback.pos);
+		}
+		var argTypes: Array<Null<ComplexType>>, isVoid: Bool;
+		switch functionType {
+			case TFun(fnArgs, ret):
+				// convert arguments (which may allocate) before entering the zone
+				argTypes = fnArgs.length == args.length ? fnArgs.map(a -> TypeTools.toComplexType(a.t)) : [for (_ in args) null];
+				isVoid = Context.follow(ret).match(TAbstract(_.get() => {pack: [], name: 'Void'}, _));
+			default:
+				Context.error('@gcFreeCallback can only be used on cpp.Callable arguments', callback.pos);
+		}
+		var argNames = [for (i in 0...args.length) '__gcFreeArg$i'];
+		var call = macro @:pos(pos) $callback($a{argNames.map(name -> macro $i{name})});
+		var exprs = new Array<Expr>();
+		for (i in 0...args.length) {
+			var name = argNames[i];
+			exprs.push(macro var $name: ${argTypes[i]} = ${args[i]});
+		}
+		exprs.push(macro HaxeCBridge.enterGCFreeCallback());
+		if (isVoid) {
+			exprs.push(call);
+			exprs.push(macro HaxeCBridge.exitGCFreeCallback());
+		} else {
+			exprs.push(macro var __gcFreeResult = $call);
+			exprs.push(macro HaxeCBridge.exitGCFreeCallback());
+			exprs.push(macro __gcFreeResult);
+		}
+		return {expr: EBlock(exprs), pos: pos};
+	}
+
 	static function isLibraryBuild() {
 		return Context.defined('dll_link') || Context.defined('static_link');
 	}
@@ -321,6 +435,85 @@ class HaxeCBridge {
 		return Context.defined('dll_link');
 	}
 
+	static function isStatsEnabled() {
+		return Context.defined('HaxeCBridge.stats');
+	}
+
+	/**
+		Capacity of the lock-free native call ring, calls beyond this spill into a slower locked overflow list
+
+		Set with `-D HaxeCBridge.queueCapacity=N` (must be a power of two)
+	**/
+	static function getQueueCapacity(): Int {
+		var value = Context.definedValue('HaxeCBridge.queueCapacity');
+		if (value == null || value == '') {
+			return 1024;
+		}
+		var capacity = Std.parseInt(value);
+		if (capacity == null || capacity < 2 || (capacity & (capacity - 1)) != 0) {
+			Context.fatalError('HaxeCBridge.queueCapacity must be a power of two (got "$value")', Context.currentPos());
+		}
+		return capacity;
+	}
+
+	/**
+		Default budget for a single drain of the native call queue, after which the haxe thread yields to haxe events
+		A value of 0 disables that part of the budget
+	**/
+	static function getDrainBudget(): {maxCalls: Int, maxSeconds: Float} {
+		var maxCallsValue = Context.definedValue('HaxeCBridge.drainMaxCalls');
+		var maxSecondsValue = Context.definedValue('HaxeCBridge.drainMaxSeconds');
+		var maxCalls = (maxCallsValue == null || maxCallsValue == '') ? 0 : Std.parseInt(maxCallsValue);
+		var maxSeconds = (maxSecondsValue == null || maxSecondsValue == '') ? 0.005 : Std.parseFloat(maxSecondsValue);
+		if (maxCalls == null || maxCalls < 0) {
+			Context.fatalError('HaxeCBridge.drainMaxCalls must be a non-negative integer (got "$maxCallsValue")', Context.currentPos());
+		}
+		if (Math.isNaN(maxSeconds) || maxSeconds < 0) {
+			Context.fatalError('HaxeCBridge.drainMaxSeconds must be a non-negative number of seconds (got "$maxSecondsValue")', Context.currentPos());
+		}
+		return {maxCalls: maxCalls, maxSeconds: maxSeconds};
+	}
+
+	/**
+		Number of threads in the pool executing `@workerThread` functions when it is started on first use, 0 for one per hardware thread
+
+		Set with `-D HaxeCBridge.workerThreads=N`
+	**/
+	static function getWorkerThreadCount(): Int {
+		var value = Context.definedValue('HaxeCBridge.workerThreads');
+		if (value == null || value == '') {
+			return 0;
+		}
+		var count = Std.parseInt(value);
+		if (count == null || count < 0) {
+			Context.fatalError('HaxeCBridge.workerThreads must be a non-negative integer (got "$value")', Context.currentPos());
+		}
+		return count;
+	}
+
+	/**
+		Returns the index of the lane named by `@lane("name")`, or -1 if the function has no lane and runs on the haxe main thread
+	**/
+	static function getLaneIndex(f: ClassField): Int {
+		var laneMeta = f.meta.extract('lane')[0];
+		if (laneMeta == null) return -1;
+		var name = switch laneMeta.params {
+			case [{expr: EConst(CString(name))}] if (~/^[A-Za-z0-9_.\-]+$/.match(name)):
+				name;
+			default:
+				Context.error('Incorrect usage, syntax is @lane(name: String) where the name contains only letters, numbers, "_", "-" and "."', laneMeta.pos);
+		}
+		#if (haxe_ver < 4.2)
+		Context.error('@lane requires haxe 4.2 or newer, where each thread can have its own event loop', laneMeta.pos);
+		#end
+		var index = laneNames.indexOf(name);
+		if (index == -1) {
+			index = laneNames.length;
+			laneNames.push(name);
+		}
+		return index;
+	}
+
 	static function getCNameMeta(meta: MetaAccess): Null<String> {
 		var cNameMeta = meta.extract('HaxeCBridge.name')[0];
 		return if (cNameMeta != null) {
@@ -335,6 +528,10 @@ class HaxeCBridge {
 
 	static function generateHeader(ctx: CConverterContext, namespace: String) {
 		ctx.requireHeader('stdbool.h', false); // we use bool for _stopHaxeThread()
+		ctx.requireHeader('stdint.h', false); // we use uint64_t for HaxeCBridgeNativeCallCounters
+		if (isStatsEnabled()) {
+			ctx.requireHeader('stddef.h', false); // we use size_t for _getBridgeStats()
+		}
 
 		var includes = ctx.includes.copy();
 		// sort includes, by <, " and alphabetically
@@ -347,6 +544,19 @@ class HaxeCBridge {
 		});
 
 		var prefix = isDynamicLink() ? 'API_PREFIX' : '';
+
+		// generated variants are declared immediately after the function they were generated from
+		var functionDeclarations = new Array<CDeclaration>();
+		for (fn in ctx.functionDeclarations) {
+			functionDeclarations.push(fn);
+			switch fn.kind {
+				case Function(sig):
+					for (variant in functionInfo.get(sig.name).variants) {
+						functionDeclarations.push(variant.declaration);
+					}
+				default:
+			}
+		}
 		
 		return code('
 			/**
@@ -376,7 +586,27 @@ class HaxeCBridge {
 				');
 			} else '')
 
+			// lets C code test for @lane functions, which are only generated with haxe 4.2 or newer
+			+ (if (laneNames.length > 0) '#define ${namespace}_HAS_LANES 1\n\n' else '')
+
 			+ 'typedef void (* HaxeExceptionCallback) (const char* exceptionInfo);\n'
+			+ code('
+				typedef struct HaxeCBridgeNativeCallCounters {
+					uint64_t drains; // number of times the haxe thread drained the native call queue
+					uint64_t calls; // number of native calls executed
+					uint64_t countBudgetHits; // number of drains that yielded to haxe events because the call count budget was reached
+					uint64_t timeBudgetHits; // number of drains that yielded to haxe events because the time budget was reached
+				} HaxeCBridgeNativeCallCounters;
+			')
+			+ (if (isStatsEnabled()) code('
+				typedef struct HaxeCBridgeFunctionStats {
+					const char* name; // C function name
+					uint64_t calls; // number of calls, including calls to generated variants such as _batch() and _async()
+					uint64_t queueWaitNanoseconds; // total time calls spent queued before executing on the haxe thread
+					uint64_t executionNanoseconds; // total time spent executing calls
+					uint64_t exceptions; // number of calls that threw an unhandled exception
+				} HaxeCBridgeFunctionStats;
+			') else '')
 			+ (if (ctx.supportTypeDeclarations.length > 0) ctx.supportTypeDeclarations.map(d -> CPrinter.printDeclaration(d, true)).join(';\n') + ';\n\n'; else '')
 			+ (if (ctx.typeDeclarations.length > 0) ctx.typeDeclarations.map(d -> CPrinter.printDeclaration(d, true)).join(';\n') + ';\n'; else '')
 
@@ -396,6 +626,41 @@ class HaxeCBridge {
 				 */
 				$prefix const char* ${namespace}_initializeHaxeThread(HaxeExceptionCallback unhandledExceptionCallback);
 
+				/**
+				 * Initializes haxe on the calling thread instead of starting a haxe thread, for apps that run their own main loop. Use this in place of `${namespace}_initializeHaxeThread()`, haxe can only be initialized once.
+				 *
+				 * The calling thread becomes the haxe main thread and runs the haxe main() function before this returns. Haxe functions called from this thread execute directly, without a thread hop.
+				 * Haxe events and calls made from other threads only execute when this thread calls `${namespace}_pumpHaxeEvents()`. Between pumps the thread does not hold up garbage collection on other haxe threads.
+				 *
+				 * @param unhandledExceptionCallback a callback to execute if an unhandled exception occurs on the haxe main thread. Use `NULL` for no callback
+				 * @returns `NULL` if haxe initializes successfully or a null-terminated C string if an error occurs during initialization
+				 */
+				$prefix const char* ${namespace}_initializeHaxeInline(HaxeExceptionCallback unhandledExceptionCallback);
+
+				/**
+				 * Runs one iteration of the haxe event loop on the thread that called `${namespace}_initializeHaxeInline()`: calls queued from other threads and haxe events that are due are executed.
+				 *
+				 * If there is no work ready the thread waits up to `maxSeconds` for a haxe event or a call from another thread, use 0 to return immediately.
+				 * Calling `${namespace}_stopHaxeThreadIfRunning()` on this thread outside of a pump stops haxe before returning, otherwise haxe stops during a later pump.
+				 *
+				 * Thread-safety: must be called on the thread that initialized haxe inline
+				 *
+				 * @returns the number of seconds until the next scheduled haxe event (suitable as the timeout of your main loop), 0 if more work is ready, or -1 if no haxe event is scheduled or haxe is not running
+				 */
+				$prefix double ${namespace}_pumpHaxeEvents(double maxSeconds);
+
+				/**
+				 * Returns a file descriptor that becomes readable when haxe has work for the host, so haxe can be waited on together with other descriptors in a single `epoll_wait()` or `poll()`
+				 *
+				 * The descriptor becomes readable when a `_submit()` ticket completes and, when haxe runs inline, when a call is queued from another thread or the next haxe event is due.
+				 * It is reset by `${namespace}_pumpHaxeEvents()`, hosts that do not pump can reset it by reading 8 bytes from it. The descriptor is owned by the library and must not be closed.
+				 *
+				 * Thread-safety: can be called on any thread
+				 *
+				 * @returns the file descriptor, or -1 if not supported on this platform (Linux only)
+				 */
+				$prefix int ${namespace}_getEventFd(void);
+
 				/**
 				 * Stops the haxe thread, blocking until the thread has completed. Once ended, it cannot be restarted (this is because static variable state will be retained from the last run).
 				 *
@@ -411,9 +676,120 @@ class HaxeCBridge {
 				 */
 				$prefix void ${namespace}_stopHaxeThreadIfRunning(bool waitOnScheduledEvents);
 
+				/**
+				 * Starts the pool of threads that execute `@workerThread` functions, calls to these functions run in parallel on the pool rather than on the haxe thread
+				 *
+				 * Calling this is optional, otherwise the pool starts on the first call to a `@workerThread` function with the number of threads set by `-D HaxeCBridge.workerThreads` (default: one per hardware thread)
+				 * The pool is stopped by `${namespace}_stopHaxeThreadIfRunning()`
+				 *
+				 * Thread-safety: can be called on any thread, after `${namespace}_initializeHaxeThread()`
+				 *
+				 * @param threadCount number of worker threads, or 0 for one per hardware thread
+				 * @returns `false` if the pool has already been started, in which case the number of threads is unchanged
+				 */
+				$prefix bool ${namespace}_initializeWorkerThreads(int threadCount);
+
+				/**
+				 * Attaches the calling thread to the haxe garbage collector until `${namespace}_detachCurrentThread()`, so `@externalThread` functions called from this thread no longer attach and detach the thread on every call
+				 *
+				 * Between calls the thread is in a GC-free zone and does not hold up collections
+				 * Calls can be nested, the thread stays attached until every attach has been matched by a detach
+				 *
+				 * Thread-safety: attaches the calling thread, which must detach before it exits. Must not be called on the haxe thread or from within a haxe call
+				 */
+				$prefix void ${namespace}_attachCurrentThread(void);
+
+				/**
+				 * Detaches a thread attached with `${namespace}_attachCurrentThread()`
+				 *
+				 * Thread-safety: must be called on the attached thread, outside of any haxe call
+				 */
+				$prefix void ${namespace}_detachCurrentThread(void);
+
+				/**
+				 * Opens a transaction on the calling thread. Until the transaction is committed, calls to non-blocking `_async()` and `_submit()` functions made on this thread are recorded rather than sent to the haxe thread
+				 *
+				 * Synchronous calls made while the transaction is open are sent together with the calls recorded so far, so calls always execute in the order they were made
+				 * Transactions can be nested, recorded calls are sent when the outermost transaction is committed
+				 *
+				 * Thread-safety: can be called on any thread, each thread has its own transaction
+				 */
+				$prefix void ${namespace}_beginTransaction(void);
+
+				/**
+				 * Sends the calls recorded since `${namespace}_beginTransaction()` to the haxe thread, where they execute in a single hop, and blocks until they have completed
+				 *
+				 * Once this returns the tickets of recorded `_submit()` calls are complete and their `_result()` functions return immediately
+				 * Tickets of recorded calls cannot complete before the transaction is committed, so do not wait on them while the transaction is open
+				 * If a recorded call throws an unhandled exception the remaining calls still execute and the first exception is passed to the `HaxeExceptionCallback`
+				 *
+				 * Thread-safety: must be called on the thread that called `${namespace}_beginTransaction()`
+				 */
+				$prefix void ${namespace}_commitTransaction(void);
+
+				/**
+				 * Sets how long the haxe thread may spend executing queued calls from C before it yields to haxe events (such as `haxe.Timer` callbacks). Remaining calls execute after the haxe events have been processed
+				 *
+				 * The defaults are set with `-D HaxeCBridge.drainMaxCalls` (default 0) and `-D HaxeCBridge.drainMaxSeconds` (default 0.005)
+				 *
+				 * Thread-safety: can be called on any thread
+				 *
+				 * @param maxCalls maximum number of calls to execute before yielding, or 0 for no limit
+				 * @param maxSeconds maximum time to spend executing calls before yielding, or 0 for no limit. The deadline is checked after every call so a single long call can exceed the budget
+				 */
+				$prefix void ${namespace}_setNativeCallBudget(int maxCalls, double maxSeconds);
+
+				/**
+				 * Returns counters describing how the haxe thread has executed calls from C, including how often it had to yield to haxe events before executing all queued calls
+				 *
+				 * Thread-safety: can be called on any thread
+				 */
+				$prefix HaxeCBridgeNativeCallCounters ${namespace}_getNativeCallCounters(void);
+
+				/**
+				 * Opens a retain scope on the calling thread. Every `HaxeObject`, `HaxeString` and `HaxeStringView` returned to this thread while the scope is open is released when the scope is popped, so there is no need to release them individually
+				 *
+				 * Scopes can be nested, handles are released by the innermost open scope
+				 * This is useful for temporaries, for example handles used within a single frame
+				 *
+				 * Thread-safety: can be called on any thread, each thread has its own scopes
+				 */
+				$prefix void ${namespace}_pushRetainScope(void);
+
+				/**
+				 * Releases every handle returned to this thread since the matching `${namespace}_pushRetainScope()` in a single bulk release and closes the scope
+				 *
+				 * Handles from the scope must not be used after this call (unless they were also returned outside of the scope)
+				 *
+				 * Thread-safety: must be called on the thread that pushed the scope
+				 */
+				$prefix void ${namespace}_popRetainScope(void);
+
 		')
+		+ (if (isStatsEnabled()) code('
+				/**
+				 * Copies statistics for each exposed function into `stats`, these are totals since the last call to `${namespace}_resetBridgeStats()`
+				 *
+				 * Only available when compiled with `-D HaxeCBridge.stats`
+				 *
+				 * Thread-safety: can be called on any thread
+				 *
+				 * @param stats array to receive the statistics, may be `NULL` if `capacity` is 0
+				 * @param capacity number of elements in `stats`
+				 * @returns the number of exposed functions, if this is larger than `capacity` only the first `capacity` functions are written
+				 */
+				$prefix size_t ${namespace}_getBridgeStats(HaxeCBridgeFunctionStats* stats, size_t capacity);
+
+				/**
+				 * Resets the statistics returned by `${namespace}_getBridgeStats()` to zero
+				 *
+				 * Thread-safety: can be called on any thread
+				 */
+				$prefix void ${namespace}_resetBridgeStats(void);
+
+		') else '')
 		+ indent(1, ctx.supportFunctionDeclarations.map(fn -> CPrinter.printDeclaration(fn, true, prefix)).join(';\n\n') + ';\n\n')
-		+ indent(1, ctx.functionDeclarations.map(fn -> CPrinter.printDeclaration(fn, true, prefix)).join(';\n\n') + ';\n\n')
+		+ indent(1, functionDeclarations.map(fn -> CPrinter.printDeclaration(fn, true, prefix)).join(';\n\n') + ';\n\n')
 
 		+ code('
 			#ifdef __cplusplus
@@ -427,6 +803,11 @@ class HaxeCBridge {
 	}
 
 	static function generateImplementation(ctx: CConverterContext, namespace: String) {
+		var queueCapacity = getQueueCapacity();
+		var drainBudget = getDrainBudget();
+		var drainMaxCalls = drainBudget.maxCalls;
+		var drainMaxSeconds = drainBudget.maxSeconds;
+		var workerThreadCount = getWorkerThreadCount();
 		return code('
 			/**
 			 * HaxeCBridge Function Binding Implementation
@@ -439,9 +820,23 @@ class HaxeCBridge {
 			#include <hx/GC.h>
 			#include <HaxeCBridge.h>
 			#include <assert.h>
-			#include <queue>
-			#include <utility>
+			#include <stdint.h>
 			#include <atomic>
+			#include <chrono>
+			#include <condition_variable>
+			#include <deque>
+			#include <exception>
+			#include <mutex>
+			#include <thread>
+			#include <type_traits>
+			#include <utility>
+			#include <vector>
+			#if defined(__linux__)
+			#include <unistd.h>
+			#include <sys/syscall.h>
+			#include <linux/futex.h>
+			#include <sys/timerfd.h>
+			#endif
 
 			// include generated bindings header
 		')
@@ -462,42 +857,64 @@ class HaxeCBridge {
 		+ ctx.implementationIncludes.map(CPrinter.printInclude).join('\n') + '\n'
 		+ code('
 
+			// defined by the HaxeCBridge runtime class
+			extern thread_local bool haxeCBridgeInGCFreeZone;
+
 			namespace HaxeCBridgeInternal {
 
 				// we cannot use hxcpps HxCreateDetachedThread() because we cannot wait on these threads to end on unix because they are detached threads
 				#if defined(HX_WINDOWS)
+				typedef HANDLE NativeThreadHandle;
 				HANDLE haxeThreadNativeHandle = nullptr;
 				DWORD haxeThreadNativeId = 0; // 0 is not valid thread id
+				bool createNativeThread(DWORD (WINAPI *func)(void *), void *param, HANDLE* handle, DWORD* id = nullptr) {
+					*handle = CreateThread(NULL, 0, func, param, 0, id);
+					return *handle != 0;
+				}
 				bool createHaxeThread(DWORD (WINAPI *func)(void *), void *param) {
-					haxeThreadNativeHandle = CreateThread(NULL, 0, func, param, 0, &haxeThreadNativeId);
-					return haxeThreadNativeHandle != 0;
+					return createNativeThread(func, param, &haxeThreadNativeHandle, &haxeThreadNativeId);
 				}
 				bool waitForThreadExit(HANDLE handle) {
 					DWORD result = WaitForSingleObject(handle, INFINITE);
 					return result != WAIT_FAILED;
 				}
+				void detachThread(HANDLE handle) {
+					CloseHandle(handle);
+				}
 				#else
+				typedef pthread_t NativeThreadHandle;
 				pthread_t haxeThreadNativeHandle;
-				bool createHaxeThread(void *(*func)(void *), void *param) {
+				bool createNativeThread(void *(*func)(void *), void *param, pthread_t* handle) {
 					// same as HxCreateDetachedThread(func, param) but without detaching the thread
 
 					pthread_attr_t attr;
 					if (pthread_attr_init(&attr) != 0)
 						return false;
-					if (pthread_create(&haxeThreadNativeHandle, &attr, func, param) != 0 )
+					if (pthread_create(handle, &attr, func, param) != 0 )
 						return false;
 					if (pthread_attr_destroy(&attr) != 0)
 						return false;
 					return true;
 				}
+				bool createHaxeThread(void *(*func)(void *), void *param) {
+					return createNativeThread(func, param, &haxeThreadNativeHandle);
+				}
 				bool waitForThreadExit(pthread_t handle) {
 					int result = pthread_join(handle, NULL);
 					return result == 0;
 				}
+				void detachThread(pthread_t handle) {
+					pthread_detach(handle);
+				}
 				#endif
 
 				std::atomic<bool> threadStarted = { false };
 				std::atomic<bool> threadRunning = { false };
+				// set by _initializeHaxeInline(), the haxe main thread is then a host thread that runs haxe events in _pumpHaxeEvents()
+				std::atomic<bool> inlineHost = { false };
+				bool pumping = false; // only accessed on the inline host thread
+				// true on the inline host thread while it is parked between pumps with no haxe frames on its stack
+				thread_local bool inlineHostParked = false;
 				// once haxe statics are initialized we cannot clear them for a clean restart
 				std::atomic<bool> staticsInitialized = { false };
 
@@ -509,97 +926,1225 @@ class HaxeCBridge {
 				HxSemaphore threadInitSemaphore;
 				HxMutex threadManageMutex;
 
-				void defaultExceptionHandler(const char* info) {
-					printf("Unhandled haxe exception: %s\\n", info);
-				}
+				/**
+				 * File descriptor returned by _getEventFd(), readable when haxe has work for the host
+				 *
+				 * This is a timerfd rather than an eventfd so that one descriptor covers both wakeups from other threads (armed to expire after 1ns) and the next haxe event on the inline host
+				 */
+				struct EventFd {
+					std::atomic<int> fd;
+					std::atomic<bool> signalled; // set by signal(), so the inline host does not overwrite a wakeup when it re-arms the timer
+					HxMutex createMutex;
+
+					EventFd(): fd(-1), signalled(false) {}
+
+					#if defined(__linux__)
+					int get() {
+						int current = fd.load(std::memory_order_acquire);
+						if (current >= 0) return current;
+						AutoLock lock(createMutex);
+						if (fd.load(std::memory_order_relaxed) < 0) {
+							int created = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+							fd.store(created, std::memory_order_release);
+							// readable straight away so the host checks for work it may have missed before it had the descriptor
+							signal();
+						}
+						return fd.load(std::memory_order_relaxed);
+					}
 
-				typedef void (* MainThreadCallback)(void* data);
-				HxMutex queueMutex;
-				std::queue<std::pair<MainThreadCallback, void*>> queue;
+					// thread-safe, makes the descriptor readable
+					void signal() {
+						signalled.store(true);
+						setTimeout(0);
+					}
 
-				void runInMainThread(MainThreadCallback callback, void* data) {
-					queueMutex.Lock();
-					queue.push(std::make_pair(callback, data));
-					queueMutex.Unlock();
-					HaxeCBridge::wakeMainThread();
-				}
+					// called on the inline host thread before running haxe work
+					void reset() {
+						int current = fd.load(std::memory_order_acquire);
+						if (current < 0) return;
+						signalled.store(false);
+						uint64_t expirations;
+						while (read(current, &expirations, sizeof(expirations)) > 0) {}
+					}
 
-				// called on the haxe main thread
-				void processNativeCalls() {
-					AutoLock lock(queueMutex);
-					while(!queue.empty()) {
-						std::pair<MainThreadCallback, void*> pair = queue.front();
-						queue.pop();
-						pair.first(pair.second);
+					// called on the inline host thread after running haxe work, the descriptor becomes readable when the next haxe event is due (never if negative)
+					void rearm(double nextEventSeconds) {
+						setTimeout(nextEventSeconds);
+						if (signalled.load()) {
+							setTimeout(0);
+						}
 					}
-				}
 
-				bool hasPendingNativeCalls() {
-					AutoLock lock(queueMutex);
-					return !queue.empty();
-				}
-				
-				#if defined(HX_WINDOWS)
-				bool isHaxeMainThread() {
-					return threadRunning &&
-					(GetCurrentThreadId() == haxeThreadNativeId) &&
-					(haxeThreadNativeId != 0);
+					void setTimeout(double seconds) {
+						int current = fd.load(std::memory_order_acquire);
+						if (current < 0) return;
+						struct itimerspec timeout = {};
+						if (seconds >= 0) {
+							// a zero it_value disarms the timer so expire after at least 1ns
+							uint64_t ns = seconds > 0 ? (uint64_t) (seconds * 1e9) : 0;
+							ns = ns > 0 ? ns : 1;
+							timeout.it_value.tv_sec = (time_t) (ns / 1000000000ULL);
+							timeout.it_value.tv_nsec = (long) (ns % 1000000000ULL);
+						}
+						timerfd_settime(current, 0, &timeout, nullptr);
+					}
+					#else
+					int get() { return -1; }
+					void signal() {}
+					void reset() {}
+					void rearm(double) {}
+					#endif
+				} eventFd;
+
+				// wakes the haxe main thread after queuing a call, an inline host learns of the call from its event fd
+				void wakeMainThread() {
+					HaxeCBridge::wakeMainThread();
+					if (inlineHost.load(std::memory_order_relaxed)) {
+						eventFd.signal();
+					}
 				}
-				#else
-				bool isHaxeMainThread() {
-					return threadRunning && pthread_equal(haxeThreadNativeHandle, pthread_self());
+
+				void defaultExceptionHandler(const char* info) {
+					printf("Unhandled haxe exception: %s\\n", info);
 				}
-				#endif
-			}
 
-			THREAD_FUNC_TYPE haxeMainThreadFunc(void *data) {
-				HX_TOP_OF_STACK
-				HaxeCBridgeInternal::HaxeThreadData* threadData = (HaxeCBridgeInternal::HaxeThreadData*) data;
+				// set by _initializeHaxeThread(), used for exceptions thrown on threads other than the haxe thread
+				HaxeExceptionCallback haxeExceptionCallback = defaultExceptionHandler;
 
-				HaxeCBridgeInternal::threadRunning = true;
+				// true on threads registered with the hxcpp GC by the bridge (other than the haxe thread)
+				bool& threadIsAttached() {
+					static thread_local bool attached = false;
+					return attached;
+				}
 
-				threadData->initExceptionInfo = nullptr;
+				// highest address of the stack of the calling thread, registering a thread with this as its top lets the GC scan every frame the thread will use
+				void* threadStackTop() {
+					#if defined(HX_WINDOWS)
+					return ((NT_TIB*) NtCurrentTeb())->StackBase;
+					#elif defined(__APPLE__)
+					return pthread_get_stackaddr_np(pthread_self());
+					#else
+					#if defined(__linux__)
+					void* stackAddress = nullptr;
+					size_t stackSize = 0;
+					pthread_attr_t attr;
+					if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+						pthread_attr_getstack(&attr, &stackAddress, &stackSize);
+						pthread_attr_destroy(&attr);
+					}
+					if (stackAddress != nullptr) {
+						return (char*) stackAddress + stackSize;
+					}
+					#endif
+					// fallback: only frames below the caller are scanned
+					return __builtin_frame_address(0);
+					#endif
+				}
 
-				// copy out callback
-				HaxeExceptionCallback haxeExceptionCallback = threadData->haxeExceptionCallback;
+				/**
+				 * Leaves the GC-free zone the thread is parked in (within a @gcFreeCallback, or on the inline host thread between pumps) for the duration of a call into haxe
+				 */
+				struct GCFreeZoneReentry {
+					bool reentered;
+					bool wasParked;
+
+					GCFreeZoneReentry(): reentered(haxeCBridgeInGCFreeZone), wasParked(inlineHostParked) {
+						if (reentered) {
+							haxeCBridgeInGCFreeZone = false;
+							inlineHostParked = false;
+							hx::ExitGCFreeZone();
+						}
+					}
 
-				bool firstRun = !HaxeCBridgeInternal::staticsInitialized;
+					~GCFreeZoneReentry() {
+						if (reentered) {
+							hx::EnterGCFreeZone();
+							haxeCBridgeInGCFreeZone = true;
+							inlineHostParked = wasParked;
+						}
+					}
+				};
 
-				// See hx::Init in StdLibs.cpp for reference
-				if (!HaxeCBridgeInternal::staticsInitialized) try {
-					::hx::Boot();
-					__boot_all();
-					HaxeCBridgeInternal::staticsInitialized = true;
-				} catch(Dynamic initException) {
-					// hxcpp init failure or uncaught haxe runtime exception
-					threadData->initExceptionInfo = initException->toString().utf8_str();
-				}
+				/**
+				 * State of a thread attached with _attachCurrentThread()
+				 *
+				 * Between calls an attached thread sits in a GC-free zone so it never holds up a collection
+				 */
+				struct ThreadAttachment {
+					int count; // _attachCurrentThread() calls not yet matched by _detachCurrentThread()
+					int activeCalls; // @externalThread calls executing on this thread
+				};
 
-				if (HaxeCBridgeInternal::staticsInitialized) { // initialized without error
-					// blocks running the event loop
-					// keeps alive until manual stop is called
-					HaxeCBridge::mainThreadInit(HaxeCBridgeInternal::isHaxeMainThread);
-					HaxeCBridgeInternal::threadInitSemaphore.Set();
-					HaxeCBridge::mainThreadRun(
-						HaxeCBridgeInternal::processNativeCalls,
-						HaxeCBridgeInternal::hasPendingNativeCalls,
-						haxeExceptionCallback
-					);
-				} else {
-					// failed to initialize statics; unlock init semaphore so _initializeHaxeThread can continue and report the exception 
-					HaxeCBridgeInternal::threadInitSemaphore.Set();
+				ThreadAttachment& threadAttachment() {
+					static thread_local ThreadAttachment attachment = { 0, 0 };
+					return attachment;
 				}
 
-				HaxeCBridgeInternal::threadRunning = false;
+				/**
+				 * Lets the calling thread execute haxe code for the duration of an @externalThread call
+				 *
+				 * Attached threads only leave their GC-free zone, other threads are attached for the call with hx::NativeAttach
+				 */
+				struct ExternalThreadScope {
+					GCFreeZoneReentry reentry; // constructed first so the thread is out of a parked GC-free zone before attaching
+					bool attachedForCall;
+					bool wasAttached;
+					typename std::aligned_storage<sizeof(hx::NativeAttach), alignof(hx::NativeAttach)>::type nativeAttach;
+
+					ExternalThreadScope(): wasAttached(threadIsAttached()) {
+						ThreadAttachment& attachment = threadAttachment();
+						attachedForCall = attachment.count == 0;
+						if (attachedForCall) {
+							new (&nativeAttach) hx::NativeAttach();
+						} else if (attachment.activeCalls++ == 0) {
+							hx::ExitGCFreeZone();
+						}
+						// blocking on the haxe thread during the call must not hold up collections
+						threadIsAttached() = true;
+					}
 
-				THREAD_FUNC_RET
-			}
-			
+					~ExternalThreadScope() {
+						threadIsAttached() = wasAttached;
+						if (attachedForCall) {
+							((hx::NativeAttach*) &nativeAttach)->~NativeAttach();
+						} else if (--threadAttachment().activeCalls == 0) {
+							hx::EnterGCFreeZone();
+						}
+					}
+				};
+
+				typedef void (* MainThreadCallback)(void* data);
+
+				/**
+				 * Limits the work done by a single drain of the native call queue so queued calls cannot starve haxe events
+				 */
+				struct DrainBudget {
+					enum Limit { None, Count, Time };
+
+					size_t maxCalls; // 0 for no limit
+					bool hasDeadline;
+					std::chrono::steady_clock::time_point deadline;
+					size_t calls;
+					Limit exhaustedBy;
+
+					DrainBudget(size_t maxCalls, double maxSeconds): maxCalls(maxCalls), hasDeadline(maxSeconds > 0), calls(0), exhaustedBy(None) {
+						if (hasDeadline) {
+							deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(maxSeconds));
+						}
+					}
+
+					bool exhausted() {
+						if (maxCalls > 0 && calls >= maxCalls) {
+							exhaustedBy = Count;
+							return true;
+						}
+						// checked after every call so a drain overruns the deadline by at most one call
+						if (hasDeadline && calls > 0 && std::chrono::steady_clock::now() >= deadline) {
+							exhaustedBy = Time;
+							return true;
+						}
+						return false;
+					}
+				};
+
+				/**
+				 * Multi-producer single-consumer queue of native calls
+				 *
+				 * Calls are pushed into a bounded lock-free ring (based on the bounded MPMC queue by Dmitry Vyukov) so enqueuing never waits on the haxe thread executing calls
+				 * If the ring is full calls spill into a mutex-protected overflow list. While the overflow list is non-empty all pushes are diverted to it, so calls from any one thread always execute in order
+				 */
+				struct CallQueue {
+					static const size_t capacity = $queueCapacity;
+					static const size_t mask = capacity - 1;
+
+					struct Cell {
+						std::atomic<size_t> sequence;
+						MainThreadCallback callback;
+						void* data;
+					};
+
+					struct OverflowNode {
+						MainThreadCallback callback;
+						void* data;
+						OverflowNode* next;
+					};
+
+					Cell cells[capacity];
+					std::atomic<size_t> enqueuePosition;
+					size_t dequeuePosition; // only accessed by the consumer
+
+					HxMutex overflowMutex;
+					OverflowNode* overflowHead;
+					OverflowNode* overflowTail;
+					std::atomic<size_t> overflowCount;
+
+					CallQueue(): enqueuePosition(0), dequeuePosition(0), overflowHead(nullptr), overflowTail(nullptr), overflowCount(0) {
+						for (size_t i = 0; i < capacity; i++) {
+							cells[i].sequence.store(i, std::memory_order_relaxed);
+						}
+					}
+
+					// thread-safe
+					void push(MainThreadCallback callback, void* data) {
+						if (overflowCount.load(std::memory_order_acquire) == 0 && tryPushRing(callback, data)) {
+							return;
+						}
+						OverflowNode* node = new OverflowNode { callback, data, nullptr };
+						AutoLock lock(overflowMutex);
+						if (overflowTail != nullptr) {
+							overflowTail->next = node;
+						} else {
+							overflowHead = node;
+						}
+						overflowTail = node;
+						overflowCount.fetch_add(1, std::memory_order_release);
+					}
+
+					// consumer only; executes queued calls until the queue is empty or the budget is exhausted (if a call throws, calls after it remain queued)
+					void drain(DrainBudget& budget) {
+						MainThreadCallback callback;
+						void* data;
+						while (!budget.exhausted() && tryPopRing(callback, data)) {
+							budget.calls++;
+							callback(data);
+						}
+
+						if (budget.exhaustedBy != DrainBudget::None) {
+							// the budget only counts as hit if it left calls queued
+							if (!hasPending()) budget.exhaustedBy = DrainBudget::None;
+							return;
+						}
+						if (overflowCount.load(std::memory_order_acquire) == 0) return;
+
+						// detach the overflow list so calls execute without holding the lock
+						OverflowNode* node;
+						{
+							AutoLock lock(overflowMutex);
+							node = overflowHead;
+							overflowHead = nullptr;
+							overflowTail = nullptr;
+						}
+						while (node != nullptr) {
+							if (budget.exhausted()) {
+								requeueOverflow(node);
+								return;
+							}
+							OverflowNode* next = node->next;
+							callback = node->callback;
+							data = node->data;
+							delete node;
+							overflowCount.fetch_sub(1, std::memory_order_release);
+							budget.calls++;
+							try {
+								callback(data);
+							} catch(...) {
+								requeueOverflow(next);
+								throw;
+							}
+							node = next;
+						}
+					}
+
+					// return unexecuted calls to the front of the overflow list
+					void requeueOverflow(OverflowNode* first) {
+						if (first == nullptr) return;
+						AutoLock lock(overflowMutex);
+						OverflowNode* last = first;
+						while (last->next != nullptr) last = last->next;
+						last->next = overflowHead;
+						if (overflowHead == nullptr) overflowTail = last;
+						overflowHead = first;
+					}
+
+					// consumer only
+					bool hasPending() {
+						Cell* cell = &cells[dequeuePosition & mask];
+						return
+							cell->sequence.load(std::memory_order_acquire) == dequeuePosition + 1 ||
+							overflowCount.load(std::memory_order_acquire) > 0;
+					}
+
+					bool tryPushRing(MainThreadCallback callback, void* data) {
+						size_t position = enqueuePosition.load(std::memory_order_relaxed);
+						for (;;) {
+							Cell* cell = &cells[position & mask];
+							size_t sequence = cell->sequence.load(std::memory_order_acquire);
+							intptr_t diff = (intptr_t) sequence - (intptr_t) position;
+							if (diff == 0) {
+								if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+									cell->callback = callback;
+									cell->data = data;
+									cell->sequence.store(position + 1, std::memory_order_release);
+									return true;
+								}
+							} else if (diff < 0) {
+								return false; // ring is full
+							} else {
+								position = enqueuePosition.load(std::memory_order_relaxed);
+							}
+						}
+					}
+
+					bool tryPopRing(MainThreadCallback& callback, void*& data) {
+						Cell* cell = &cells[dequeuePosition & mask];
+						if (cell->sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+							// empty, or the producer that claimed this cell has not finished writing (it wakes the haxe thread once it has)
+							return false;
+						}
+						callback = cell->callback;
+						data = cell->data;
+						cell->sequence.store(dequeuePosition + capacity, std::memory_order_release);
+						dequeuePosition++;
+						return true;
+					}
+				};
+
+				CallQueue queue;
+
+				/**
+				 * Handles returned to a calling thread while a retain scope is open, these are released together when the scope is popped
+				 *
+				 * Scopes are stacked in a single array so pushing a scope does not allocate
+				 */
+				struct RetainScopes {
+					std::vector<void*> retained;
+					std::vector<size_t> scopeStarts;
+				};
+
+				RetainScopes& threadRetainScopes() {
+					static thread_local RetainScopes scopes;
+					return scopes;
+				}
+
+				// called on the thread receiving a HaxeObject or HaxeString
+				template <typename T>
+				inline T recordRetained(T ptr) {
+					RetainScopes& scopes = threadRetainScopes();
+					if (!scopes.scopeStarts.empty() && ptr != nullptr) {
+						scopes.retained.push_back((void*) ptr);
+					}
+					return ptr;
+				}
+
+				template <typename T>
+				inline void recordRetainedAll(T* ptrs, size_t count) {
+					for (size_t i = 0; i < count; i++) {
+						recordRetained(ptrs[i]);
+					}
+				}
+
+				template <typename View>
+				inline View recordRetainedView(View view) {
+					recordRetained(view.ptr);
+					return view;
+				}
+
+				template <typename View>
+				inline void recordRetainedViews(View* views, size_t count) {
+					for (size_t i = 0; i < count; i++) {
+						recordRetained(views[i].ptr);
+					}
+				}
+
+				template <typename View>
+				inline View recordRetainedOwner(View view) {
+					recordRetained(view.owner);
+					return view;
+				}
+
+				template <typename View>
+				inline void recordRetainedOwners(View* views, size_t count) {
+					for (size_t i = 0; i < count; i++) {
+						recordRetained(views[i].owner);
+					}
+				}
+
+				// View is a HaxeArray_ struct, which is only declared by the generated header when it is used
+				template <typename View, typename T>
+				inline View retainArray(::Array<T> array) {
+					View view;
+					if (array.mPtr == nullptr) {
+						view.data = nullptr;
+						view.length = 0;
+						view.owner = nullptr;
+					} else {
+						view.data = (decltype(view.data)) array->getBase();
+						view.length = (size_t) array->length;
+						view.owner = HaxeCBridge::retainHaxeObject(array);
+					}
+					return view;
+				}
+
+				// arrays from C use the memory of the caller without copying, unless they refer to a haxe array
+				template <typename T, typename View>
+				inline ::Array<T> arrayFromView(const View& view) {
+					if (view.owner != nullptr) {
+						return ::Array<T>(Dynamic((hx::Object *) view.owner));
+					}
+					if (view.data == nullptr) {
+						return null();
+					}
+					::Array<T> array = ::Array_obj<T>::__new();
+					array->setUnmanagedData((T*) view.data, (int) view.length);
+					return array;
+				}
+
+				// View is the HaxeStringView struct, which is only declared by the generated header when it is used
+				template <typename View>
+				inline View retainStringView(::String str) {
+					int length = 0;
+					View view;
+					view.ptr = HaxeCBridge::retainHaxeStringView(str, &length);
+					view.length = (size_t) length;
+					return view;
+				}
+
+				std::atomic<size_t> drainMaxCalls = { $drainMaxCalls };
+				std::atomic<double> drainMaxSeconds = { $drainMaxSeconds };
+
+				// only written by the haxe thread
+				struct NativeCallCounters {
+					std::atomic<uint64_t> drains;
+					std::atomic<uint64_t> calls;
+					std::atomic<uint64_t> countBudgetHits;
+					std::atomic<uint64_t> timeBudgetHits;
+				} nativeCallCounters = {};
+
+				// called on the haxe main thread
+				void processNativeCalls() {
+					DrainBudget budget(drainMaxCalls.load(std::memory_order_relaxed), drainMaxSeconds.load(std::memory_order_relaxed));
+
+					// update counters even if a call throws
+					struct RecordCounters {
+						DrainBudget& budget;
+						~RecordCounters() {
+							nativeCallCounters.drains.store(nativeCallCounters.drains.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+							nativeCallCounters.calls.store(nativeCallCounters.calls.load(std::memory_order_relaxed) + budget.calls, std::memory_order_relaxed);
+							if (budget.exhaustedBy == DrainBudget::Count) {
+								nativeCallCounters.countBudgetHits.store(nativeCallCounters.countBudgetHits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+							} else if (budget.exhaustedBy == DrainBudget::Time) {
+								nativeCallCounters.timeBudgetHits.store(nativeCallCounters.timeBudgetHits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+							}
+						}
+					} recordCounters = { budget };
+
+					queue.drain(budget);
+				}
+
+				bool hasPendingNativeCalls() {
+					return queue.hasPending();
+				}
+
+				inline void cpuRelax() {
+					#if defined(_MSC_VER)
+					YieldProcessor();
+					#elif defined(__i386__) || defined(__x86_64__)
+					__builtin_ia32_pause();
+					#elif defined(__aarch64__) || defined(__arm__)
+					__asm__ __volatile__("yield");
+					#endif
+				}
+
+				/**
+				 * Signals the calling thread when a call executed on the haxe thread has completed
+				 *
+				 * Most calls complete within a few microseconds so the waiter spins briefly before parking on a futex (linux) or a semaphore
+				 * Slots are reusable: call reset() before queuing the next call
+				 */
+				struct CompletionSlot {
+					enum { Pending = 0, Complete = 1, Sleeping = 2 };
+					static const int spinCount = 256;
+
+					std::atomic<int> state;
+					#if !defined(__linux__)
+					HxSemaphore semaphore;
+					#endif
+
+					CompletionSlot(): state(Complete) {}
+
+					void reset() {
+						state.store(Pending, std::memory_order_relaxed);
+					}
+
+					bool isComplete() {
+						return state.load(std::memory_order_acquire) == Complete;
+					}
+
+					void signal() {
+						if (state.exchange(Complete, std::memory_order_acq_rel) == Sleeping) {
+							#if defined(__linux__)
+							syscall(SYS_futex, (int*) &state, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+							#else
+							semaphore.Set();
+							#endif
+						}
+					}
+
+					void wait() {
+						for (int i = 0; i < spinCount; i++) {
+							if (isComplete()) return;
+							cpuRelax();
+						}
+						int expected = Pending;
+						if (!state.compare_exchange_strong(expected, Sleeping, std::memory_order_acq_rel)) {
+							return; // completed while we were spinning
+						}
+						// attached threads must not hold up collections while they sleep (unless the thread is already parked in a GC-free zone)
+						bool gcFree = threadIsAttached() && !haxeCBridgeInGCFreeZone;
+						if (gcFree) hx::EnterGCFreeZone();
+						#if defined(__linux__)
+						while (!isComplete()) {
+							syscall(SYS_futex, (int*) &state, FUTEX_WAIT_PRIVATE, (int) Sleeping, nullptr, nullptr, 0);
+						}
+						#else
+						semaphore.Wait();
+						#endif
+						if (gcFree) hx::ExitGCFreeZone();
+					}
+				};
+
+				// each calling thread has at most one synchronous call in flight so a single slot per thread can be reused for every call
+				CompletionSlot& threadCompletionSlot() {
+					static thread_local CompletionSlot slot;
+					return slot;
+				}
+
+				/**
+				 * Pool of heap nodes for calls that outlive the C function that queued them
+				 *
+				 * Nodes are allocated on calling threads and released on the haxe thread. Released nodes are pushed onto a shared lock-free stack
+				 * which a calling thread claims in its entirety (so there is no ABA problem) and keeps as a thread-local free list
+				 */
+				template <typename T>
+				struct NodePool {
+					struct Node {
+						T value; // must be first so a T* can be converted back to its Node*
+						Node* next;
+					};
+
+					struct LocalFreeList {
+						Node* head;
+						LocalFreeList(): head(nullptr) {}
+						~LocalFreeList() {
+							// return nodes to the shared stack when the thread exits
+							while (head != nullptr) {
+								Node* next = head->next;
+								push(head);
+								head = next;
+							}
+						}
+					};
+
+					static std::atomic<Node*>& shared() {
+						static std::atomic<Node*> head(nullptr);
+						return head;
+					}
+
+					static void push(Node* node) {
+						std::atomic<Node*>& head = shared();
+						Node* expected = head.load(std::memory_order_relaxed);
+						do {
+							node->next = expected;
+						} while (!head.compare_exchange_weak(expected, node, std::memory_order_release, std::memory_order_relaxed));
+					}
+
+					static T* allocate() {
+						static thread_local LocalFreeList local;
+						if (local.head == nullptr) {
+							local.head = shared().exchange(nullptr, std::memory_order_acquire);
+						}
+						Node* node = local.head;
+						if (node != nullptr) {
+							local.head = node->next;
+						} else {
+							node = new Node();
+						}
+						return &node->value;
+					}
+
+					static void release(T* value) {
+						push((Node*) value);
+					}
+				};
+
+				// base of the heap nodes behind HaxeCBridgeTicket handles
+				struct Ticket {
+					CompletionSlot completion;
+
+					void complete() {
+						completion.signal();
+						// hosts waiting on the event fd check their tickets
+						eventFd.signal();
+					}
+				};
+
+				// copies a haxe string into a caller-provided buffer as null-terminated UTF-8 (truncated at a character boundary if it does not fit)
+				bool copyStringInto(::String str, char* buf, size_t cap, size_t* outLen) {
+					const char* utf8 = "";
+					size_t length = 0;
+					if (str.raw_ptr() != nullptr) {
+						utf8 = str.utf8_str();
+						#ifdef HX_SMART_STRINGS
+						length = str.isUTF16Encoded() ? strlen(utf8) : (size_t) str.length;
+						#else
+						length = (size_t) str.length;
+						#endif
+					}
+					if (outLen != nullptr) {
+						*outLen = length;
+					}
+					if (cap == 0) return false; // no room for the null terminator
+					size_t n = length;
+					if (n >= cap) {
+						n = cap - 1;
+						// do not split a multi-byte UTF-8 sequence
+						while (n > 0 && (((unsigned char) utf8[n]) & 0xC0) == 0x80) n--;
+					}
+					memcpy(buf, utf8, n);
+					buf[n] = 0;
+					return n == length;
+				}
+
+				// copy a C string into malloc-owned memory so it can be used after the caller returns
+				char* copyCString(const char* str) {
+					if (str == nullptr) return nullptr;
+					size_t length = strlen(str);
+					char* copy = (char*) malloc(length + 1);
+					memcpy(copy, str, length + 1);
+					return copy;
+				}
+
+				// View is the HaxeBytes struct and BytesPtr is haxe.io.Bytes, which are only declared when used
+				template <typename View, typename BytesPtr>
+				inline View retainBytes(BytesPtr bytes) {
+					View view;
+					if (bytes.mPtr == nullptr) {
+						view.data = nullptr;
+						view.length = 0;
+						view.owner = nullptr;
+					} else {
+						view.data = (unsigned char*) bytes->b->getBase();
+						view.length = (size_t) bytes->length;
+						view.owner = HaxeCBridge::retainHaxeObject(bytes);
+					}
+					return view;
+				}
+
+				// bytes from C use the memory of the caller without copying, unless they refer to a haxe.io.Bytes
+				template <typename BytesObj, typename View>
+				inline Dynamic bytesFromView(const View& view) {
+					if (view.owner != nullptr) {
+						return Dynamic((hx::Object *) view.owner);
+					}
+					if (view.data == nullptr) {
+						return null();
+					}
+					::Array<unsigned char> data = ::Array_obj<unsigned char>::__new();
+					data->setUnmanagedData(view.data, (int) view.length);
+					return BytesObj::__new((int) view.length, data);
+				}
+
+				// copy the elements of a HaxeArray_ or HaxeBytes struct into malloc-owned memory, structs that refer to a haxe object are passed by their owner
+				template <typename View>
+				View copyArrayView(View view) {
+					if (view.owner != nullptr || view.data == nullptr) {
+						view.data = nullptr;
+						return view;
+					}
+					size_t size = sizeof(*view.data) * view.length;
+					void* copy = malloc(size > 0 ? size : 1);
+					memcpy(copy, view.data, size);
+					view.data = (decltype(view.data)) copy;
+					return view;
+				}
+
+				// copy the bytes of a HaxeStringView into malloc-owned memory (null-terminated)
+				template <typename View>
+				View copyStringView(View view) {
+					if (view.ptr == nullptr) return view;
+					char* copy = (char*) malloc(view.length + 1);
+					memcpy(copy, view.ptr, view.length);
+					copy[view.length] = 0;
+					view.ptr = copy;
+					return view;
+				}
+
+				/**
+				 * Non-blocking calls recorded on a calling thread between beginTransaction() and commitTransaction()
+				 *
+				 * Recorded calls are sent to the haxe thread as a single queue entry
+				 */
+				struct Transaction {
+					int depth;
+					bool submitted; // recorded calls have been sent to the haxe thread, the buffer is cleared on next use
+					std::vector<std::pair<MainThreadCallback, void*>> calls;
+
+					Transaction(): depth(0), submitted(false) {}
+
+					std::vector<std::pair<MainThreadCallback, void*>>& buffer() {
+						// the calling thread only uses its transaction again once the haxe thread has finished reading the buffer
+						if (submitted) {
+							calls.clear();
+							submitted = false;
+						}
+						return calls;
+					}
+				};
+
+				Transaction& threadTransaction() {
+					static thread_local Transaction transaction;
+					return transaction;
+				}
+
+				// called on the haxe main thread; every recorded call executes, even if an earlier call throws
+				void runTransaction(void* p) {
+					Transaction* transaction = (Transaction*) p;
+					// read the buffer up-front, the calling thread may resume and reuse it as soon as the last call completes
+					std::pair<MainThreadCallback, void*>* calls = transaction->calls.data();
+					size_t count = transaction->calls.size();
+					bool threw = false;
+					Dynamic exception;
+					for (size_t i = 0; i < count; i++) {
+						try {
+							calls[i].first(calls[i].second);
+						} catch(Dynamic runtimeException) {
+							if (!threw) {
+								threw = true;
+								exception = runtimeException;
+							}
+						}
+					}
+					if (threw) {
+						throw exception;
+					}
+				}
+
+				void submitTransaction(Transaction& transaction) {
+					transaction.submitted = true;
+					queue.push(runTransaction, &transaction);
+					HaxeCBridgeInternal::wakeMainThread();
+				}
+
+				// queue a call the caller will wait on
+				void runInMainThread(MainThreadCallback callback, void* data) {
+					Transaction& transaction = threadTransaction();
+					if (transaction.depth > 0 && !transaction.buffer().empty()) {
+						// preserve call order by sending the calls recorded so far together with this one
+						transaction.calls.push_back(std::make_pair(callback, data));
+						submitTransaction(transaction);
+						return;
+					}
+					queue.push(callback, data);
+					HaxeCBridgeInternal::wakeMainThread();
+				}
+
+				// queue a call without waiting for it, if a transaction is open on this thread the call is recorded until commit
+				void queueInMainThread(MainThreadCallback callback, void* data) {
+					Transaction& transaction = threadTransaction();
+					if (transaction.depth > 0) {
+						transaction.buffer().push_back(std::make_pair(callback, data));
+						return;
+					}
+					queue.push(callback, data);
+					HaxeCBridgeInternal::wakeMainThread();
+				}
+
+				/**
+				 * Pointers released from C threads, queued like non-blocking calls so a release executes after the calls the releasing thread made before it (inside a transaction it is recorded until commit)
+				 *
+				 * Releasing does not wake the haxe thread until half a ring of releases is pending, so releasing many objects costs a handful of wakeups
+				 */
+				struct ReleaseList {
+					static const size_t wakeThreshold = CallQueue::capacity / 2;
+
+					static std::atomic<size_t>& pending() {
+						static std::atomic<size_t> count(0);
+						return count;
+					}
+
+					// thread-safe
+					void push(void* ptr) {
+						enqueue(release, ptr, false);
+					}
+
+					// thread-safe, copies the array into a single entry
+					void pushAll(void* const* ptrs, size_t count) {
+						if (count == 0) return;
+						Block* block = (Block*) malloc(sizeof(Block) + sizeof(void*) * (count - 1));
+						block->count = count;
+						memcpy(block->ptrs, ptrs, sizeof(void*) * count);
+						// large blocks wake the haxe thread so their memory is not held until the next wakeup
+						enqueue(releaseBlock, block, count >= wakeThreshold);
+					}
+
+					void enqueue(MainThreadCallback callback, void* data, bool wake) {
+						size_t pendingCount = pending().fetch_add(1, std::memory_order_relaxed) + 1;
+						Transaction& transaction = threadTransaction();
+						if (transaction.depth > 0) {
+							transaction.buffer().push_back(std::make_pair(callback, data));
+							return;
+						}
+						queue.push(callback, data);
+						if (wake || pendingCount >= wakeThreshold) {
+							HaxeCBridgeInternal::wakeMainThread();
+						}
+					}
+
+					struct Block {
+						size_t count;
+						void* ptrs[1];
+					};
+
+					static void release(void* ptr) {
+						pending().fetch_sub(1, std::memory_order_relaxed);
+						HaxeCBridge::releaseHaxePtr(ptr);
+					}
+
+					static void releaseBlock(void* p) {
+						pending().fetch_sub(1, std::memory_order_relaxed);
+						Block* block = (Block*) p;
+						releaseAll(block->ptrs, block->count);
+						free(block);
+					}
+
+					static void releaseAll(void* const* ptrs, size_t count) {
+						for (size_t i = 0; i < count; i++) {
+							HaxeCBridge::releaseHaxePtr(ptrs[i]);
+						}
+					}
+				};
+
+				ReleaseList releaseList;
+				
+				#if defined(HX_WINDOWS)
+				bool isHaxeMainThread() {
+					return threadRunning &&
+					(GetCurrentThreadId() == haxeThreadNativeId) &&
+					(haxeThreadNativeId != 0);
+				}
+				#else
+				bool isHaxeMainThread() {
+					return threadRunning && pthread_equal(haxeThreadNativeHandle, pthread_self());
+				}
+				#endif
+
+				/**
+				 * Pool of haxe-attached threads that execute calls to `@workerThread` functions in parallel
+				 *
+				 * Each worker owns a deque. Calls are pushed onto the back of the deques in turn, a worker takes calls from the front of its own deque and steals from the back of the others once it runs out
+				 * Idle workers sleep in a GC-free zone so they do not hold up collections on other threads
+				 */
+				struct WorkerPool {
+					struct Call {
+						MainThreadCallback callback;
+						void* data;
+					};
+
+					struct Worker {
+						WorkerPool* pool;
+						HxMutex mutex;
+						std::deque<Call> calls;
+						NativeThreadHandle thread;
+						bool threadCreated;
+					};
+
+					Worker* workers;
+					size_t workerCount;
+					std::atomic<bool> started;
+					std::atomic<bool> stopping;
+					std::atomic<size_t> nextWorker;
+					std::atomic<size_t> pending; // calls pushed and not yet taken by a worker
+					std::atomic<int> sleeping;
+					std::mutex sleepMutex;
+					std::condition_variable wakeCondition;
+					HxMutex manageMutex;
+					std::atomic<size_t> workerReferences; // running worker threads plus one held until stop(), the last reference frees the workers
+
+					WorkerPool(): workers(nullptr), workerCount(0), started(false), stopping(false), nextWorker(0), pending(0), sleeping(0), workerReferences(0) {}
+
+					static bool& isWorkerThread() {
+						static thread_local bool isWorker = false;
+						return isWorker;
+					}
+
+					// returns false if the pool has already been started
+					bool start(size_t count) {
+						AutoLock lock(manageMutex);
+						if (started.load(std::memory_order_acquire)) return false;
+						if (count == 0) count = std::thread::hardware_concurrency();
+						if (count == 0) count = 1;
+						workers = new Worker[count];
+						workerCount = count;
+						// threads may exit before this returns so hold a reference for each one up-front, unused references are dropped below
+						workerReferences.store(count + 1, std::memory_order_relaxed);
+						size_t created = 0;
+						for (size_t i = 0; i < count; i++) {
+							workers[i].pool = this;
+							workers[i].threadCreated = createNativeThread(threadFunc, &workers[i], &workers[i].thread);
+							if (workers[i].threadCreated) {
+								created++;
+							} else {
+								releaseWorkers();
+							}
+						}
+						// deques without a thread are emptied by the other workers
+						if (created == 0) workerCount = 0;
+						started.store(true, std::memory_order_release);
+						return true;
+					}
+
+					// thread-safe
+					void push(MainThreadCallback callback, void* data) {
+						if (workerCount == 0 || stopping.load(std::memory_order_acquire)) {
+							// no worker threads could be created, or the workers have been told to exit
+							runInMainThread(callback, data);
+							return;
+						}
+						// counted before the call is visible so a worker that finds the call never sees the count underflow
+						pending.fetch_add(1, std::memory_order_seq_cst);
+						Worker& worker = workers[nextWorker.fetch_add(1, std::memory_order_relaxed) % workerCount];
+						{
+							AutoLock lock(worker.mutex);
+							worker.calls.push_back(Call { callback, data });
+						}
+						if (sleeping.load(std::memory_order_seq_cst) > 0) {
+							std::lock_guard<std::mutex> lock(sleepMutex);
+							wakeCondition.notify_one();
+						}
+					}
+
+					bool tryTake(size_t index, Call& call) {
+						if (pending.load(std::memory_order_acquire) == 0) return false;
+						for (size_t i = 0; i < workerCount; i++) {
+							Worker& worker = workers[(index + i) % workerCount];
+							AutoLock lock(worker.mutex);
+							if (worker.calls.empty()) continue;
+							if (i == 0) {
+								call = worker.calls.front();
+								worker.calls.pop_front();
+							} else {
+								// steal the most recently pushed call, leaving older calls to their owner
+								call = worker.calls.back();
+								worker.calls.pop_back();
+							}
+							pending.fetch_sub(1, std::memory_order_relaxed);
+							return true;
+						}
+						return false;
+					}
+
+					void run(size_t index) {
+						Call call;
+						for (;;) {
+							if (tryTake(index, call)) {
+								try {
+									call.callback(call.data);
+								} catch(Dynamic runtimeException) {
+									::String info = runtimeException.mPtr != nullptr ? runtimeException->toString() : HX_CSTRING("null");
+									haxeExceptionCallback(info.utf8_str());
+								}
+								continue;
+							}
+							if (stopping.load(std::memory_order_acquire) && pending.load(std::memory_order_acquire) == 0) return;
+
+							hx::EnterGCFreeZone();
+							{
+								std::unique_lock<std::mutex> lock(sleepMutex);
+								sleeping.fetch_add(1, std::memory_order_seq_cst);
+								while (pending.load(std::memory_order_seq_cst) == 0 && !stopping.load(std::memory_order_acquire)) {
+									wakeCondition.wait(lock);
+								}
+								sleeping.fetch_sub(1, std::memory_order_relaxed);
+							}
+							hx::ExitGCFreeZone();
+						}
+					}
+
+					// queued calls complete before the workers exit; if join is false the worker threads are detached and this returns without waiting for them
+					void stop(bool join) {
+						AutoLock lock(manageMutex);
+						if (!started.load(std::memory_order_acquire) || stopping.load(std::memory_order_acquire)) return;
+						{
+							std::lock_guard<std::mutex> sleepLock(sleepMutex);
+							stopping.store(true, std::memory_order_release);
+						}
+						wakeCondition.notify_all();
+						// every thread is joined or detached here, so a later stop() has nothing left to release
+						for (size_t i = 0; i < workerCount; i++) {
+							if (!workers[i].threadCreated) continue;
+							if (join) {
+								waitForThreadExit(workers[i].thread);
+							} else {
+								detachThread(workers[i].thread);
+							}
+						}
+						releaseWorkers();
+					}
+
+					void releaseWorkers() {
+						if (workerReferences.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+							delete[] workers;
+						}
+					}
+
+					static THREAD_FUNC_TYPE threadFunc(void* p) {
+						HX_TOP_OF_STACK
+						Worker* worker = (Worker*) p;
+						WorkerPool* pool = worker->pool;
+						isWorkerThread() = true;
+						threadIsAttached() = true;
+						pool->run(worker - pool->workers);
+						threadIsAttached() = false;
+						hx::UnregisterCurrentThread();
+						pool->releaseWorkers();
+						THREAD_FUNC_RET
+					}
+				};
+
+				WorkerPool workerPool;
+				std::atomic<int> defaultWorkerThreadCount = { $workerThreadCount };
+
+				// queue a call on the worker pool that the caller will wait on, the pool is started on first use
+				void runInWorkerThread(MainThreadCallback callback, void* data) {
+					if (!workerPool.started.load(std::memory_order_acquire)) {
+						workerPool.start((size_t) defaultWorkerThreadCount.load(std::memory_order_relaxed));
+					}
+					workerPool.push(callback, data);
+				}
+			}
+
+		')
+		+ generateLaneImplementation()
+		+ code('
+
+			THREAD_FUNC_TYPE haxeMainThreadFunc(void *data) {
+				HX_TOP_OF_STACK
+				HaxeCBridgeInternal::HaxeThreadData* threadData = (HaxeCBridgeInternal::HaxeThreadData*) data;
+
+				HaxeCBridgeInternal::threadRunning = true;
+
+				threadData->initExceptionInfo = nullptr;
+
+				// copy out callback
+				HaxeExceptionCallback haxeExceptionCallback = threadData->haxeExceptionCallback;
+
+				bool firstRun = !HaxeCBridgeInternal::staticsInitialized;
+
+				// See hx::Init in StdLibs.cpp for reference
+				if (!HaxeCBridgeInternal::staticsInitialized) try {
+					::hx::Boot();
+					__boot_all();
+					HaxeCBridgeInternal::staticsInitialized = true;
+				} catch(Dynamic initException) {
+					// hxcpp init failure or uncaught haxe runtime exception
+					threadData->initExceptionInfo = initException->toString().utf8_str();
+				}
+
+				if (HaxeCBridgeInternal::staticsInitialized) { // initialized without error
+					// blocks running the event loop
+					// keeps alive until manual stop is called
+					HaxeCBridge::mainThreadInit(HaxeCBridgeInternal::isHaxeMainThread);
+					HaxeCBridgeInternal::threadIsAttached() = true;
+					HaxeCBridgeInternal::initializeLanes();
+					HaxeCBridgeInternal::threadInitSemaphore.Set();
+					HaxeCBridge::mainThreadRun(
+						HaxeCBridgeInternal::processNativeCalls,
+						HaxeCBridgeInternal::hasPendingNativeCalls,
+						haxeExceptionCallback
+					);
+				} else {
+					// failed to initialize statics; unlock init semaphore so _initializeHaxeThread can continue and report the exception 
+					HaxeCBridgeInternal::threadInitSemaphore.Set();
+				}
+
+				HaxeCBridgeInternal::threadRunning = false;
+
+				THREAD_FUNC_RET
+			}
+
+			namespace HaxeCBridgeInternal {
+
+				// copies an init exception so it can be returned to C after the string has been collected
+				const char* initExceptionResult(const char* initExceptionInfo) {
+					const int returnInfoMax = 1024;
+					static char returnInfo[returnInfoMax] = ""; // statically allocated for return safety
+					strncpy(returnInfo, initExceptionInfo, returnInfoMax);
+					returnInfo[returnInfoMax - 1] = 0;
+					return returnInfo;
+				}
+
+				// the inline host thread sits in a GC-free zone between pumps so it does not hold up collections on worker and lane threads
+				void parkInlineHost() {
+					haxeCBridgeInGCFreeZone = true;
+					inlineHostParked = true;
+					hx::EnterGCFreeZone();
+				}
+
+				void unparkInlineHost() {
+					hx::ExitGCFreeZone();
+					inlineHostParked = false;
+					haxeCBridgeInGCFreeZone = false;
+				}
+
+				// called on the inline host thread while it is not parked, runs the event loop until it ends
+				void endInlineHost() {
+					HaxeCBridge::mainThreadEndInline(processNativeCalls, hasPendingNativeCalls, haxeExceptionCallback);
+					threadRunning = false;
+					threadIsAttached() = false;
+					hx::UnregisterCurrentThread();
+				}
+
+				// returns nullptr on success or the init exception
+				const char* initializeInlineHost(HaxeExceptionCallback haxeExceptionCallback) {
+					// register the host thread with the GC, scanning its whole stack because haxe is called from frames above this one
+					hx::SetTopOfStack((int*) threadStackTop(), true);
+					#if defined(HX_WINDOWS)
+					haxeThreadNativeId = GetCurrentThreadId();
+					#else
+					haxeThreadNativeHandle = pthread_self();
+					#endif
+					inlineHost = true;
+					threadRunning = true;
+
+					const char* initExceptionInfo = nullptr;
+					if (!staticsInitialized) try {
+						::hx::Boot();
+						__boot_all();
+						staticsInitialized = true;
+					} catch(Dynamic initException) {
+						initExceptionInfo = initExceptionResult(initException->toString().utf8_str());
+					}
+
+					if (!staticsInitialized) {
+						threadRunning = false;
+						inlineHost = false;
+						hx::UnregisterCurrentThread();
+						return initExceptionInfo;
+					}
+
+					HaxeCBridge::mainThreadInit(isHaxeMainThread);
+					threadIsAttached() = true;
+					initializeLanes();
+					startLanes();
+					// runs main()
+					HaxeCBridge::mainThreadStartInline(processNativeCalls, hasPendingNativeCalls, haxeExceptionCallback);
+					if (HaxeCBridge::isMainLoopActive()) {
+						parkInlineHost();
+					} else {
+						// main() stopped haxe without waiting on scheduled events
+						endInlineHost();
+					}
+					return nullptr;
+				}
+
+			}
+			
 			HAXE_C_BRIDGE_LINKAGE
 			const char* ${namespace}_initializeHaxeThread(HaxeExceptionCallback unhandledExceptionCallback) {
 				HaxeCBridgeInternal::HaxeThreadData threadData;
 				threadData.haxeExceptionCallback = unhandledExceptionCallback == nullptr ? HaxeCBridgeInternal::defaultExceptionHandler : unhandledExceptionCallback;
 				threadData.initExceptionInfo = nullptr;
+				HaxeCBridgeInternal::haxeExceptionCallback = threadData.haxeExceptionCallback;
 
 				{
 					// mutex prevents two threads calling this function from being able to start two haxe threads
@@ -612,6 +2157,10 @@ class HaxeCBridge {
 
 						// wait until the thread is initialized and ready
 						HaxeCBridgeInternal::threadInitSemaphore.Wait();
+
+						if (threadData.initExceptionInfo == nullptr) {
+							HaxeCBridgeInternal::startLanes();
+						}
 					} else {
 						threadData.initExceptionInfo = "haxe thread cannot be started twice";
 					}
@@ -620,22 +2169,89 @@ class HaxeCBridge {
 				if (threadData.initExceptionInfo != nullptr) {
 					${namespace}_stopHaxeThreadIfRunning(false);
 
-					const int returnInfoMax = 1024;
-					static char returnInfo[returnInfoMax] = ""; // statically allocated for return safety
-					strncpy(returnInfo, threadData.initExceptionInfo, returnInfoMax);
-					return returnInfo;
+					return HaxeCBridgeInternal::initExceptionResult(threadData.initExceptionInfo);
 				} else {
 					return nullptr;
 				}
 			}
 
+			HAXE_C_BRIDGE_LINKAGE
+			const char* ${namespace}_initializeHaxeInline(HaxeExceptionCallback unhandledExceptionCallback) {
+				HaxeExceptionCallback haxeExceptionCallback = unhandledExceptionCallback == nullptr ? HaxeCBridgeInternal::defaultExceptionHandler : unhandledExceptionCallback;
+				HaxeCBridgeInternal::haxeExceptionCallback = haxeExceptionCallback;
+
+				AutoLock lock(HaxeCBridgeInternal::threadManageMutex);
+				if (HaxeCBridgeInternal::threadStarted) {
+					return HaxeCBridgeInternal::initExceptionResult("haxe thread cannot be started twice");
+				}
+				HaxeCBridgeInternal::threadStarted = true;
+				return HaxeCBridgeInternal::initializeInlineHost(haxeExceptionCallback);
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			double ${namespace}_pumpHaxeEvents(double maxSeconds) {
+				#ifdef HXCPP_DEBUG
+				assert((!HaxeCBridgeInternal::threadRunning || HaxeCBridgeInternal::isHaxeMainThread()) && "haxe events can only be pumped on the thread that called ${namespace}_initializeHaxeInline()");
+				assert(!HaxeCBridgeInternal::pumping && "${namespace}_pumpHaxeEvents() cannot be called from within haxe");
+				#endif
+				if (!HaxeCBridgeInternal::inlineHost || !HaxeCBridgeInternal::isHaxeMainThread() || HaxeCBridgeInternal::pumping) {
+					return -1;
+				}
+
+				HaxeCBridgeInternal::unparkInlineHost();
+				HaxeCBridgeInternal::eventFd.reset();
+				HaxeCBridgeInternal::pumping = true;
+				double nextEventSeconds = HaxeCBridge::pumpEvents(maxSeconds, HaxeCBridgeInternal::haxeExceptionCallback);
+				HaxeCBridgeInternal::pumping = false;
+
+				if (HaxeCBridge::isMainLoopActive()) {
+					HaxeCBridgeInternal::eventFd.rearm(nextEventSeconds);
+					HaxeCBridgeInternal::parkInlineHost();
+				} else {
+					// stopped during this pump
+					HaxeCBridgeInternal::endInlineHost();
+					nextEventSeconds = -1;
+				}
+				return nextEventSeconds;
+			}
+
 			HAXE_C_BRIDGE_LINKAGE
 			void ${namespace}_stopHaxeThreadIfRunning(bool waitOnScheduledEvents) {
-				if (HaxeCBridgeInternal::isHaxeMainThread()) {
+				if (HaxeCBridgeInternal::isHaxeMainThread() && HaxeCBridgeInternal::inlineHostParked) {
+					// inline host parked between pumps, run the event loop here until it ends
+					// (from main(), within a pump or within a call from the host the next branch ends the loop at a later pump instead)
+					// workers and lanes may be waiting on calls to this thread so they are not joined
+					HaxeCBridgeInternal::unparkInlineHost();
+					HaxeCBridgeInternal::workerPool.stop(false);
+					HaxeCBridgeInternal::stopLanes(waitOnScheduledEvents, false);
+					HaxeCBridge::endMainThread(waitOnScheduledEvents);
+					HaxeCBridgeInternal::endInlineHost();
+				} else if (HaxeCBridgeInternal::isHaxeMainThread()) {
+					HaxeCBridgeInternal::GCFreeZoneReentry reentry;
 					// it is possible for stopHaxeThread to be called from within the haxe thread, while another thread is waiting on for the thread to end
 					// so it is important the haxe thread does not wait on certain locks
+					HaxeCBridgeInternal::workerPool.stop(false);
+					HaxeCBridgeInternal::stopLanes(waitOnScheduledEvents, false);
 					HaxeCBridge::endMainThread(waitOnScheduledEvents);
+				} else if (HaxeCBridgeInternal::WorkerPool::isWorkerThread() || HaxeCBridgeInternal::isAnyLaneThread() || (HaxeCBridgeInternal::inlineHost && HaxeCBridgeInternal::threadRunning)) {
+					// workers and lanes cannot wait for themselves to exit, so the worker pool, lanes and the haxe thread are told to stop without waiting
+					// (an inline host stops during its next pump)
+					HaxeCBridgeInternal::workerPool.stop(false);
+					HaxeCBridgeInternal::stopLanes(waitOnScheduledEvents, false);
+					struct Callback {
+						static void waitOnScheduledEvents(void*) {
+							HaxeCBridge::endMainThread(true);
+						}
+						static void skipScheduledEvents(void*) {
+							HaxeCBridge::endMainThread(false);
+						}
+					};
+					HaxeCBridgeInternal::queue.push(waitOnScheduledEvents ? Callback::waitOnScheduledEvents : Callback::skipScheduledEvents, nullptr);
+					HaxeCBridgeInternal::wakeMainThread();
 				} else {
+					// workers and lanes may be waiting on calls to the haxe thread so they are stopped first
+					HaxeCBridgeInternal::workerPool.stop(true);
+					HaxeCBridgeInternal::stopLanes(waitOnScheduledEvents, true);
 					AutoLock lock(HaxeCBridgeInternal::threadManageMutex);
 					if (HaxeCBridgeInternal::threadRunning) {
 						struct Callback {
@@ -652,14 +2268,53 @@ class HaxeCBridge {
 				}
 			}
 			
+			HAXE_C_BRIDGE_LINKAGE
+			int ${namespace}_getEventFd() {
+				return HaxeCBridgeInternal::eventFd.get();
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			bool ${namespace}_initializeWorkerThreads(int threadCount) {
+				#ifdef HXCPP_DEBUG
+				assert(HaxeCBridgeInternal::staticsInitialized && "haxe not initialized, use ${namespace}_initializeHaxeThread() before starting worker threads");
+				#endif
+				return HaxeCBridgeInternal::workerPool.start(threadCount > 0 ? (size_t) threadCount : 0);
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			void ${namespace}_attachCurrentThread() {
+				HaxeCBridgeInternal::ThreadAttachment& attachment = HaxeCBridgeInternal::threadAttachment();
+				#ifdef HXCPP_DEBUG
+				assert(attachment.activeCalls == 0 && "cannot attach a thread from within a haxe call");
+				#endif
+				if (attachment.count++ == 0) {
+					hx::RegisterCurrentThread(HaxeCBridgeInternal::threadStackTop());
+					hx::EnterGCFreeZone();
+				}
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			void ${namespace}_detachCurrentThread() {
+				HaxeCBridgeInternal::ThreadAttachment& attachment = HaxeCBridgeInternal::threadAttachment();
+				#ifdef HXCPP_DEBUG
+				assert(attachment.count > 0 && "thread not attached, use ${namespace}_attachCurrentThread()");
+				assert(attachment.activeCalls == 0 && "cannot detach a thread from within a haxe call");
+				#endif
+				if (attachment.count > 0 && --attachment.count == 0) {
+					hx::ExitGCFreeZone();
+					hx::UnregisterCurrentThread();
+				}
+			}
+
 			HAXE_C_BRIDGE_LINKAGE
 			void ${namespace}_releaseHaxeObject(void* objPtr) {
-				struct Callback {
-					static void run(void* data) {
-						HaxeCBridge::releaseHaxePtr(data);
-					}
-				};
-				HaxeCBridgeInternal::runInMainThread(Callback::run, objPtr);
+				if (HaxeCBridgeInternal::isHaxeMainThread()) {
+					HaxeCBridgeInternal::GCFreeZoneReentry reentry;
+					HaxeCBridge::releaseHaxePtr(objPtr);
+				} else {
+					// released in bulk the next time the haxe thread processes native calls
+					HaxeCBridgeInternal::releaseList.push(objPtr);
+				}
 			}
 			
 			HAXE_C_BRIDGE_LINKAGE
@@ -668,16 +2323,535 @@ class HaxeCBridge {
 				${namespace}_releaseHaxeObject((void*) strPtr);
 			}
 
+			HAXE_C_BRIDGE_LINKAGE
+			void ${namespace}_releaseHaxeObjects(void* const* objPtrs, size_t count) {
+				if (HaxeCBridgeInternal::isHaxeMainThread()) {
+					HaxeCBridgeInternal::GCFreeZoneReentry reentry;
+					HaxeCBridgeInternal::ReleaseList::releaseAll(objPtrs, count);
+				} else {
+					HaxeCBridgeInternal::releaseList.pushAll(objPtrs, count);
+				}
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			void ${namespace}_releaseHaxeStrings(const char* const* strPtrs, size_t count) {
+				${namespace}_releaseHaxeObjects((void* const*) strPtrs, count);
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			void ${namespace}_pushRetainScope() {
+				HaxeCBridgeInternal::RetainScopes& scopes = HaxeCBridgeInternal::threadRetainScopes();
+				scopes.scopeStarts.push_back(scopes.retained.size());
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			void ${namespace}_popRetainScope() {
+				HaxeCBridgeInternal::RetainScopes& scopes = HaxeCBridgeInternal::threadRetainScopes();
+				if (scopes.scopeStarts.empty()) return;
+				size_t start = scopes.scopeStarts.back();
+				scopes.scopeStarts.pop_back();
+				${namespace}_releaseHaxeObjects(scopes.retained.data() + start, scopes.retained.size() - start);
+				scopes.retained.resize(start);
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			void ${namespace}_beginTransaction() {
+				HaxeCBridgeInternal::threadTransaction().depth++;
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			void ${namespace}_commitTransaction() {
+				HaxeCBridgeInternal::Transaction& transaction = HaxeCBridgeInternal::threadTransaction();
+				if (transaction.depth == 0) return;
+				if (--transaction.depth > 0) return; // nested transactions are committed by the outermost commit
+
+				std::vector<std::pair<HaxeCBridgeInternal::MainThreadCallback, void*>>& calls = transaction.buffer();
+				if (calls.empty()) return;
+
+				struct Callback {
+					static void run(void* data) {
+						((HaxeCBridgeInternal::CompletionSlot*) data)->signal();
+					}
+				};
+
+				// the last recorded call signals the committing thread
+				HaxeCBridgeInternal::CompletionSlot& completion = HaxeCBridgeInternal::threadCompletionSlot();
+				completion.reset();
+				calls.push_back(std::make_pair(Callback::run, &completion));
+				HaxeCBridgeInternal::submitTransaction(transaction);
+				completion.wait();
+
+				transaction.buffer();
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			void ${namespace}_setNativeCallBudget(int maxCalls, double maxSeconds) {
+				HaxeCBridgeInternal::drainMaxCalls.store(maxCalls > 0 ? (size_t) maxCalls : 0, std::memory_order_relaxed);
+				HaxeCBridgeInternal::drainMaxSeconds.store(maxSeconds > 0 ? maxSeconds : 0, std::memory_order_relaxed);
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			HaxeCBridgeNativeCallCounters ${namespace}_getNativeCallCounters() {
+				HaxeCBridgeNativeCallCounters counters;
+				counters.drains = HaxeCBridgeInternal::nativeCallCounters.drains.load(std::memory_order_relaxed);
+				counters.calls = HaxeCBridgeInternal::nativeCallCounters.calls.load(std::memory_order_relaxed);
+				counters.countBudgetHits = HaxeCBridgeInternal::nativeCallCounters.countBudgetHits.load(std::memory_order_relaxed);
+				counters.timeBudgetHits = HaxeCBridgeInternal::nativeCallCounters.timeBudgetHits.load(std::memory_order_relaxed);
+				return counters;
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			void ${namespace}_waitTicket(void* ticket) {
+				((HaxeCBridgeInternal::Ticket*) ticket)->completion.wait();
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			bool ${namespace}_pollTicket(void* ticket) {
+				return ((HaxeCBridgeInternal::Ticket*) ticket)->completion.isComplete();
+			}
+
 		')
-		+ ctx.functionDeclarations.map(d -> generateFunctionImplementation(namespace, d)).join('\n') + '\n'
+		+ (if (isStatsEnabled()) generateStatsImplementation(ctx, namespace) else '')
+		+ generateAnonStructImplementation()
+		+ ctx.functionDeclarations.mapi((i, d) -> generateFunctionImplementation(namespace, d, i)).join('\n') + '\n'
 		;
 	}
 
-	static function generateFunctionImplementation(namespace: String, d: CDeclaration) {
+	/**
+		Threads, queues and event loops of the lanes used by `@lane("name")` functions
+	**/
+	static function generateLaneImplementation() {
+		var laneCount = laneNames.length;
+		if (laneCount == 0) return code('
+			namespace HaxeCBridgeInternal {
+				// no functions use @lane
+				inline bool isAnyLaneThread() { return false; }
+				inline void initializeLanes() {}
+				inline void startLanes() {}
+				inline void stopLanes(bool waitOnScheduledEvents, bool join) {}
+			}
+		');
+
+		return code('
+			namespace HaxeCBridgeInternal {
+
+				/**
+				 * A dedicated haxe thread with its own call queue and event loop, `@lane("name")` functions execute on the thread of their lane
+				 *
+				 * Calls to the same lane execute in order, calls to different lanes execute in parallel
+				 */
+				struct Lane {
+					int index;
+					const char* name;
+					CallQueue queue;
+					NativeThreadHandle thread;
+					bool threadCreated;
+					bool threadReleased; // the thread has been joined or detached
+					std::atomic<bool> running;
+					HxSemaphore initSemaphore;
+
+					Lane(): index(0), name(nullptr), threadCreated(false), threadReleased(false), running(false) {}
+				};
+
+				const int laneCount = $laneCount;
+				const char* const laneNames[$laneCount] = {
+					${laneNames.map(n -> '"$n"').join(',\n\t\t\t\t\t')}
+				};
+				Lane lanes[$laneCount];
+
+				// the lane of the calling thread, or nullptr if it is not a lane thread
+				Lane*& threadLane() {
+					static thread_local Lane* lane = nullptr;
+					return lane;
+				}
+
+				inline bool isLaneThread(int index) {
+					return threadLane() == &lanes[index];
+				}
+
+				inline bool isAnyLaneThread() {
+					return threadLane() != nullptr;
+				}
+
+				// called on the thread of a lane
+				void processLaneCalls() {
+					DrainBudget budget(drainMaxCalls.load(std::memory_order_relaxed), drainMaxSeconds.load(std::memory_order_relaxed));
+					threadLane()->queue.drain(budget);
+				}
+
+				bool hasPendingLaneCalls() {
+					return threadLane()->queue.hasPending();
+				}
+
+				// queue a call on the thread of a lane, used both for calls the caller waits on and for non-blocking calls
+				void queueInLane(int index, MainThreadCallback callback, void* data) {
+					lanes[index].queue.push(callback, data);
+					HaxeCBridge::wakeLane(index);
+				}
+
+				THREAD_FUNC_TYPE laneThreadFunc(void* p) {
+					HX_TOP_OF_STACK
+					Lane* lane = (Lane*) p;
+					threadLane() = lane;
+					threadIsAttached() = true;
+
+					HaxeCBridge::laneThreadInit(lane->index);
+					lane->running = true;
+					lane->initSemaphore.Set();
+
+					// blocks running the event loop of the lane until stopLanes()
+					HaxeCBridge::laneThreadRun(lane->index, processLaneCalls, hasPendingLaneCalls, haxeExceptionCallback);
+
+					lane->running = false;
+					threadIsAttached() = false;
+					hx::UnregisterCurrentThread();
+					THREAD_FUNC_RET
+				}
+
+				// called on the haxe main thread once it is initialized, before any lane starts
+				void initializeLanes() {
+					HaxeCBridge::lanesInit(laneCount);
+					// values returned from lanes are retained on the lane threads
+					HaxeCBridge::shareRetainTable();
+				}
+
+				// called once the haxe main thread is initialized, returns once every lane is ready to execute calls
+				void startLanes() {
+					for (int i = 0; i < laneCount; i++) {
+						lanes[i].index = i;
+						lanes[i].name = laneNames[i];
+						lanes[i].threadReleased = false;
+						lanes[i].threadCreated = createNativeThread(laneThreadFunc, &lanes[i], &lanes[i].thread);
+						if (lanes[i].threadCreated) {
+							lanes[i].initSemaphore.Wait();
+						}
+					}
+				}
+
+				// lanes finish the calls queued before they were told to stop, if join is false the lane threads are detached and this returns without waiting for them to exit
+				void stopLanes(bool waitOnScheduledEvents, bool join) {
+					struct Callback {
+						static void waitOnScheduledEvents(void*) {
+							HaxeCBridge::endLaneThread(threadLane()->index, true);
+						}
+						static void skipScheduledEvents(void*) {
+							HaxeCBridge::endLaneThread(threadLane()->index, false);
+						}
+					};
+					for (int i = 0; i < laneCount; i++) {
+						if (lanes[i].running) {
+							queueInLane(i, waitOnScheduledEvents ? Callback::waitOnScheduledEvents : Callback::skipScheduledEvents, nullptr);
+						}
+					}
+					for (int i = 0; i < laneCount; i++) {
+						if (lanes[i].threadCreated && !lanes[i].threadReleased) {
+							if (join) {
+								waitForThreadExit(lanes[i].thread);
+							} else {
+								detachThread(lanes[i].thread);
+							}
+							lanes[i].threadReleased = true;
+						}
+					}
+				}
+
+			}
+		');
+	}
+
+	/**
+		Field-by-field conversions between haxe anonymous structures and the C structs generated for them
+	**/
+	static function generateAnonStructImplementation() {
+		var keys = [for (key in CConverterContext.anonStructs.keys()) key];
+		if (keys.length == 0) return '';
+		// sorted so the generated file only changes when the structs change
+		keys.sort((a, b) -> a < b ? -1 : (a > b ? 1 : 0));
+
+		// hxcpp stores these as Float, Int, Bool or Int64 in an anonymous structure
+		inline function hxcppValueType(cType: CType) {
+			return switch cType {
+				case Ident('double' | 'float'): 'Float';
+				case Ident('bool'): 'bool';
+				case Ident('int64_t' | 'uint64_t'): '::cpp::Int64';
+				default: 'int';
+			}
+		}
+
+		var structs = keys.map(key -> {
+			var fields = CConverterContext.anonStructs.get(key);
+			code('
+				struct $key {
+					// T is the generated C struct
+					template <typename T>
+					static T toC(Dynamic o) {
+						T s = {};
+						if (o.mPtr != nullptr) {
+							${fields.map(f -> 's.${f.name} = (${hxcppValueType(f.type)}) o->__Field(HX_CSTRING("${f.haxeName}"), hx::paccDynamic);').join('\n\t\t\t\t\t\t\t')}
+						}
+						return s;
+					}
+
+					template <typename T>
+					static Dynamic toHaxe(const T& s) {
+						Dynamic o = hx::Anon_obj::Create();
+						${fields.map(f -> 'o->__SetField(HX_CSTRING("${f.haxeName}"), (${hxcppValueType(f.type)}) s.${f.name}, hx::paccDynamic);').join('\n\t\t\t\t\t\t')}
+						return o;
+					}
+				};
+			');
+		});
+
+		return code('
+
+			namespace HaxeCBridgeInternal {
+			namespace Structs {
+
+		')
+		+ structs.join('\n')
+		+ code('
+
+			}
+			}
+
+		');
+	}
+
+	/**
+		Per-function call statistics, enabled with `-D HaxeCBridge.stats`
+
+		Each thread records into its own set of counters so recording never contends with other threads, readers sum the counters of all threads
+	**/
+	static function generateStatsImplementation(ctx: CConverterContext, namespace: String) {
+		var functionNames = ctx.functionDeclarations.map(d -> switch d.kind {case Function(sig): sig.name; default: null;});
+		var functionCount = functionNames.length;
+		var arraySize = functionCount > 0 ? functionCount : 1;
+		return code('
+			namespace HaxeCBridgeInternal {
+			namespace Stats {
+
+				const size_t functionCount = $functionCount;
+				const char* const functionNames[$arraySize] = {
+					${functionNames.map(n -> '"$n"').join(',\n\t\t\t\t\t')}
+				};
+
+				struct FunctionCounters {
+					std::atomic<uint64_t> calls;
+					std::atomic<uint64_t> queueWaitNanoseconds;
+					std::atomic<uint64_t> executionNanoseconds;
+					std::atomic<uint64_t> exceptions;
+				};
+
+				// counters are only written by the owning thread, once a thread exits its counters are reused by the next new thread
+				struct ThreadCounters {
+					FunctionCounters functions[$arraySize];
+					std::atomic<bool> inUse;
+					ThreadCounters* next;
+				};
+
+				std::atomic<ThreadCounters*> allThreadCounters = { nullptr };
+
+				struct ThreadCountersOwner {
+					ThreadCounters* counters;
+
+					ThreadCountersOwner() {
+						for (counters = allThreadCounters.load(std::memory_order_acquire); counters != nullptr; counters = counters->next) {
+							bool expected = false;
+							if (!counters->inUse.load(std::memory_order_relaxed) && counters->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+								return;
+							}
+						}
+						counters = new ThreadCounters();
+						counters->inUse.store(true, std::memory_order_relaxed);
+						counters->next = allThreadCounters.load(std::memory_order_relaxed);
+						while (!allThreadCounters.compare_exchange_weak(counters->next, counters, std::memory_order_release, std::memory_order_relaxed));
+					}
+
+					~ThreadCountersOwner() {
+						counters->inUse.store(false, std::memory_order_release);
+					}
+				};
+
+				ThreadCounters& threadCounters() {
+					static thread_local ThreadCountersOwner owner;
+					return *owner.counters;
+				}
+
+				// single writer, so there is no need for an atomic read-modify-write
+				inline void add(std::atomic<uint64_t>& counter, uint64_t value) {
+					counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+				}
+
+				inline uint64_t now() {
+					return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+				}
+
+				inline int uncaughtExceptions() {
+					#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+					return std::uncaught_exceptions();
+					#else
+					return std::uncaught_exception() ? 1 : 0;
+					#endif
+				}
+
+				inline void recordCalls(size_t function, uint64_t count) {
+					add(threadCounters().functions[function].calls, count);
+				}
+
+				// records the execution of a call on the current thread, from construction until end() or destruction
+				struct Execution {
+					size_t function;
+					uint64_t startedAt;
+					uint64_t queuedAt;
+					int uncaughtAtStart;
+					bool ended;
+
+					Execution(size_t function, uint64_t queuedAt = 0): function(function), startedAt(now()), queuedAt(queuedAt != 0 ? queuedAt : startedAt), uncaughtAtStart(uncaughtExceptions()), ended(false) {}
+
+					void end(bool threw) {
+						if (ended) return;
+						ended = true;
+						FunctionCounters& counters = threadCounters().functions[function];
+						add(counters.queueWaitNanoseconds, startedAt - queuedAt);
+						add(counters.executionNanoseconds, now() - startedAt);
+						if (threw) {
+							add(counters.exceptions, 1);
+						}
+					}
+
+					~Execution() {
+						end(uncaughtExceptions() > uncaughtAtStart);
+					}
+				};
+
+				// totals at the last reset
+				HxMutex baselineMutex;
+				uint64_t baseline[$arraySize][4] = {};
+
+				void sum(uint64_t (*totals)[4]) {
+					for (size_t i = 0; i < functionCount; i++) {
+						totals[i][0] = totals[i][1] = totals[i][2] = totals[i][3] = 0;
+					}
+					for (ThreadCounters* counters = allThreadCounters.load(std::memory_order_acquire); counters != nullptr; counters = counters->next) {
+						for (size_t i = 0; i < functionCount; i++) {
+							totals[i][0] += counters->functions[i].calls.load(std::memory_order_relaxed);
+							totals[i][1] += counters->functions[i].queueWaitNanoseconds.load(std::memory_order_relaxed);
+							totals[i][2] += counters->functions[i].executionNanoseconds.load(std::memory_order_relaxed);
+							totals[i][3] += counters->functions[i].exceptions.load(std::memory_order_relaxed);
+						}
+					}
+				}
+
+			}
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			size_t ${namespace}_getBridgeStats(HaxeCBridgeFunctionStats* stats, size_t capacity) {
+				using namespace HaxeCBridgeInternal::Stats;
+				uint64_t totals[$arraySize][4];
+				AutoLock lock(baselineMutex);
+				sum(totals);
+				for (size_t i = 0; i < functionCount && i < capacity; i++) {
+					stats[i].name = functionNames[i];
+					stats[i].calls = totals[i][0] - baseline[i][0];
+					stats[i].queueWaitNanoseconds = totals[i][1] - baseline[i][1];
+					stats[i].executionNanoseconds = totals[i][2] - baseline[i][2];
+					stats[i].exceptions = totals[i][3] - baseline[i][3];
+				}
+				return functionCount;
+			}
+
+			HAXE_C_BRIDGE_LINKAGE
+			void ${namespace}_resetBridgeStats() {
+				using namespace HaxeCBridgeInternal::Stats;
+				AutoLock lock(baselineMutex);
+				sum(baseline);
+			}
+
+		');
+	}
+
+	static function isArrayCType(rootCType: CType) {
+		return switch rootCType {
+			case Ident(name): CConverterContext.arrayElementCTypes.exists(name);
+			default: false;
+		}
+	}
+
+	// HaxeArray_ and HaxeBytes structs point into haxe storage kept alive by an owner handle
+	static function isBufferCType(rootCType: CType) {
+		return isArrayCType(rootCType) || rootCType.match(Ident('HaxeBytes'));
+	}
+
+	// the hxcpp element type of a HaxeArray_ struct, 64-bit integers are spelled differently in hxcpp
+	static function getHxcppArrayElementType(rootCType: CType) {
+		var elementCType = switch rootCType {
+			case Ident(name): CConverterContext.arrayElementCTypes.get(name);
+			default: null;
+		}
+		return switch elementCType {
+			case Ident('int64_t'): '::cpp::Int64';
+			case Ident('uint64_t'): '::cpp::UInt64';
+			default: CPrinter.printType(elementCType);
+		}
+	}
+
+	static function generateFunctionImplementation(namespace: String, d: CDeclaration, functionIndex: Int) {
 		var signature = switch d.kind {case Function(sig): sig; default: null;};
+		var originalSignature = signature;
 		var haxeFunction = functionInfo.get(signature.name);
 		var hasReturnValue = !haxeFunction.rootCTypes.ret.match(Ident('void'));
 		var externalThread = haxeFunction.field.meta.has('externalThread');
+		// @workerThread calls execute on the worker pool and @lane calls on the thread of their lane, rather than the haxe thread
+		var workerThread = haxeFunction.field.meta.has('workerThread');
+		var lane = haxeFunction.lane;
+		var executingThreadName =
+			workerThread ? 'a worker thread' :
+			lane >= 0 ? 'the thread of lane "${laneNames[lane]}"' :
+			'the haxe main thread';
+		var isExecutingThread =
+			workerThread ? 'HaxeCBridgeInternal::isHaxeMainThread() || HaxeCBridgeInternal::WorkerPool::isWorkerThread()' :
+			lane >= 0 ? 'HaxeCBridgeInternal::isLaneThread($lane)' :
+			'HaxeCBridgeInternal::isHaxeMainThread()';
+		// queue a call the caller waits on
+		var runCall = (callback: String, data: String) ->
+			workerThread ? 'HaxeCBridgeInternal::runInWorkerThread($callback, $data)' :
+			lane >= 0 ? 'HaxeCBridgeInternal::queueInLane($lane, $callback, $data)' :
+			'HaxeCBridgeInternal::runInMainThread($callback, $data)';
+		// queue a call without waiting for it, transactions only record calls to the haxe main thread so calls to a lane are queued immediately
+		var queueCall = (callback: String, data: String) ->
+			lane >= 0 ? 'HaxeCBridgeInternal::queueInLane($lane, $callback, $data)' :
+			'HaxeCBridgeInternal::queueInMainThread($callback, $data)';
+
+		// optional statistics statements (-D HaxeCBridge.stats)
+		var stats = isStatsEnabled();
+		inline function statsCode(statement: String) {
+			return stats ? statement : '';
+		}
+		// calls made within a @gcFreeCallback or from the inline host thread between pumps must leave the GC-free zone
+		var reenterHaxe = 'HaxeCBridgeInternal::GCFreeZoneReentry reentry;';
+		var recordCalls = (count: String) -> statsCode('HaxeCBridgeInternal::Stats::recordCalls($functionIndex, $count);');
+		var beginExecution = (queuedAt: Null<String>) -> statsCode('HaxeCBridgeInternal::Stats::Execution execution($functionIndex${queuedAt != null ? ', $queuedAt' : ''});');
+		var endExecution = (threw: Bool) -> statsCode('execution.end($threw);');
+		var setQueuedAt = (field: String) -> statsCode('$field = HaxeCBridgeInternal::Stats::now();');
+		var queuedAtFields: Array<CField> = stats ? [{name: 'queuedAt', type: Ident('uint64_t')}] : [];
+
+		// returned handles are recorded in the retain scope of the thread receiving them
+		var returnsRetained = haxeFunction.rootCTypes.ret.match(Ident('HaxeObject') | Ident('HaxeString'));
+		var returnsView = haxeFunction.rootCTypes.ret.match(Ident('HaxeStringView'));
+		var returnsBuffer = isBufferCType(haxeFunction.rootCTypes.ret);
+		inline function recordRetained(expr: String) {
+			return
+				returnsRetained ? 'HaxeCBridgeInternal::recordRetained($expr)' :
+				returnsView ? 'HaxeCBridgeInternal::recordRetainedView($expr)' :
+				returnsBuffer ? 'HaxeCBridgeInternal::recordRetainedOwner($expr)' :
+				expr;
+		}
+		var recordBatchResults =
+			returnsRetained ? 'HaxeCBridgeInternal::recordRetainedAll(results, n);' :
+			returnsView ? 'HaxeCBridgeInternal::recordRetainedViews(results, n);' :
+			returnsBuffer ? 'HaxeCBridgeInternal::recordRetainedOwners(results, n);' :
+			'';
 
 		// rename signature args to a1, a2, a3 etc, this is to avoid possible conflict with local function variables
 		var signature: CFunctionSignature = {
@@ -687,12 +2861,24 @@ class HaxeCBridge {
 		}
 		var d: CDeclaration = { kind: Function(signature) }
 
+		// @internStrings reuses haxe strings for repeated string arguments rather than allocating a new string for each call
+		var internStrings = haxeFunction.field.meta.has('internStrings');
+
 		// cast a C type to one which works with hxcpp
 		inline function castC2Cpp(expr: String, rootCType: CType) {
 			// type cast argument before passing to hxcpp
 			return switch rootCType {
 				case Enum(_): expr; // enum to int works with implicit cast
 				case Ident('HaxeObject'): 'Dynamic((hx::Object *)$expr)'; // Dynamic cast requires including the hxcpp header of the type
+				case Ident('HaxeString') if (internStrings): 'HaxeCBridge::internString($expr, -1)';
+				case Ident('HaxeStringView'):
+					internStrings ?
+						'HaxeCBridge::internString($expr.ptr, (int) $expr.length)' :
+						'::String::create($expr.ptr, (int) $expr.length)'; // the length is known so there is no need for strlen
+				case Ident(_) if (isArrayCType(rootCType)):
+					'HaxeCBridgeInternal::arrayFromView<${getHxcppArrayElementType(rootCType)}>($expr)';
+				case Ident('HaxeBytes'): 'HaxeCBridgeInternal::bytesFromView<::haxe::io::Bytes_obj>($expr)';
+				case Ident(name) if (CConverterContext.anonStructs.exists(name)): 'HaxeCBridgeInternal::Structs::$name::toHaxe($expr)'; // copied into a new anonymous structure
 				case Ident(_), FunctionPointer(_), InlineStruct(_), Pointer(_): expr; // hxcpp auto casting works
 			}
 		}
@@ -703,11 +2889,16 @@ class HaxeCBridge {
 				case Enum(_): 'static_cast<${CPrinter.printType(cType)}>($expr)'; // need explicit cast for int -> enum
 				case Ident('HaxeObject'): 'HaxeCBridge::retainHaxeObject($expr)'; // Dynamic cast requires including the hxcpp header of the type
 				case Ident('HaxeString'): 'HaxeCBridge::retainHaxeString($expr)'; // ensure string is held by the GC (until manual release)
+				case Ident('HaxeStringView'): 'HaxeCBridgeInternal::retainStringView<${CPrinter.printType(cType)}>($expr)'; // retained like HaxeString
+				case Ident(_) if (isArrayCType(rootCType)): 'HaxeCBridgeInternal::retainArray<${CPrinter.printType(cType)}>($expr)'; // the array is retained as the owner
+				case Ident('HaxeBytes'): 'HaxeCBridgeInternal::retainBytes<${CPrinter.printType(cType)}>($expr)'; // the Bytes object is retained as the owner
+				case Ident(name) if (CConverterContext.anonStructs.exists(name)): 'HaxeCBridgeInternal::Structs::$name::toC<${CPrinter.printType(cType)}>($expr)'; // copied field-by-field
 				case Ident(_), FunctionPointer(_), InlineStruct(_), Pointer(_): expr; // hxcpp auto casting works
 			}
 		}
 
-		inline function callWithArgs(argNames: Array<String>) {
+		// returnRaw skips converting the return value to C, for code that consumes the hxcpp value directly
+		inline function callWithArgs(argNames: Array<String>, returnRaw: Bool = false) {
 			var callExpr = switch haxeFunction.kind {
 				case Constructor | Static:
 					'${haxeFunction.hxcppFunctionName}(${argNames.mapi((i, arg) -> castC2Cpp(arg, haxeFunction.rootCTypes.args[i])).join(', ')})';
@@ -718,24 +2909,24 @@ class HaxeCBridge {
 					'(${haxeFunction.hxcppClass}((hx::Object *)$a0Name, true))->${haxeFunction.field.name}(${argNames.mapi((i, arg) -> castC2Cpp(arg, argCTypes[i])).join(', ')})';
 			}
 
-			return if (hasReturnValue) {
+			return if (hasReturnValue && !returnRaw) {
 				castCpp2C(callExpr, signature.ret, haxeFunction.rootCTypes.ret);
 			} else {
 				callExpr;
 			}
 		}
 
-		if (externalThread) {
+		var implementation = if (externalThread) {
 			// straight call through
-			return (
-				code('
-					HAXE_C_BRIDGE_LINKAGE
-					${CPrinter.printDeclaration(d, false)} {
-						hx::NativeAttach autoAttach;
-						return ${callWithArgs(signature.args.map(a->a.name))};
-					}
-				')
-			);
+			code('
+				HAXE_C_BRIDGE_LINKAGE
+				${CPrinter.printDeclaration(d, false)} {
+					${recordCalls('1')}
+					HaxeCBridgeInternal::ExternalThreadScope externalThreadScope;
+					${beginExecution(null)}
+					return ${recordRetained(callWithArgs(signature.args.map(a->a.name)))};
+				}
+			');
 		} else {
 			// main thread synchronization implementation
 			var fnDataTypeName = 'Data';
@@ -747,44 +2938,50 @@ class HaxeCBridge {
 						type: InlineStruct({fields: signature.args})
 					},
 					{
-						name: 'lock',
-						type: Ident('HxSemaphore')
+						name: 'completion',
+						type: Pointer(Ident('HaxeCBridgeInternal::CompletionSlot'))
 					}
 				].concat(
 					hasReturnValue ? [{
 						name: 'ret',
 						type: signature.ret
 					}] : []
-				)
+				).concat(queuedAtFields)
 			};
 
 			var fnDataDeclaration: CDeclaration = { kind: Struct(fnDataTypeName, fnDataStruct) }
 
-			return (
+			(
 				code('
 					HAXE_C_BRIDGE_LINKAGE
 				')
 				+ CPrinter.printDeclaration(d, false) + ' {\n'
 				+ indent(1,
 					code('
-						if (HaxeCBridgeInternal::isHaxeMainThread()) {
-							return ${callWithArgs(signature.args.map(a->a.name))};
+						${recordCalls('1')}
+						if ($isExecutingThread) {
+							${reenterHaxe}
+							${beginExecution(null)}
+							return ${recordRetained(callWithArgs(signature.args.map(a->a.name)))};
 						}
 					')
 					+ CPrinter.printDeclaration(fnDataDeclaration) + ';\n'
 					+ code('
 						struct Callback {
 							static void run(void* p) {
-								// executed within the haxe main thread
+								// executed within $executingThreadName
 								$fnDataTypeName* $fnDataName = ($fnDataTypeName*) p;
+								${beginExecution('$fnDataName->queuedAt')}
 								try {
 									${hasReturnValue ?
 										'$fnDataName->ret = ${callWithArgs(signature.args.map(a->'$fnDataName->args.${a.name}'))};' :
 										'${callWithArgs(signature.args.map(a->'$fnDataName->args.${a.name}'))};'
 									}
-									$fnDataName->lock.Set();
+									${endExecution(false)}
+									$fnDataName->completion->signal();
 								} catch(Dynamic runtimeException) {
-									$fnDataName->lock.Set();
+									${endExecution(true)}
+									$fnDataName->completion->signal();
 									throw runtimeException;
 								}
 							}
@@ -794,14 +2991,16 @@ class HaxeCBridge {
 						assert(HaxeCBridgeInternal::threadRunning && "haxe thread not running, use ${namespace}_initializeHaxeThread() to activate the haxe thread");
 						#endif
 
-						$fnDataTypeName $fnDataName = { {${signature.args.map(a->a.name).join(', ')}} };
+						$fnDataTypeName $fnDataName = { {${signature.args.map(a->a.name).join(', ')}}, &HaxeCBridgeInternal::threadCompletionSlot() };
+						$fnDataName.completion->reset();
+						${setQueuedAt('$fnDataName.queuedAt')}
 
-						// queue a callback to execute ${haxeFunction.field.name}() on the main thread and wait until execution completes
-						HaxeCBridgeInternal::runInMainThread(Callback::run, &$fnDataName);
-						$fnDataName.lock.Wait();
+						// queue a callback to execute ${haxeFunction.field.name}() on $executingThreadName and wait until execution completes
+						${runCall('Callback::run', '&$fnDataName')};
+						$fnDataName.completion->wait();
 					')
 					+ if (hasReturnValue) code('
-						return $fnDataName.ret;
+						return ${recordRetained('$fnDataName.ret')};
 					') else ''
 				)
 				+ code('
@@ -809,6 +3008,488 @@ class HaxeCBridge {
 				')
 			);
 		}
+
+		// non-blocking variants copy arguments into a heap node
+		// HaxeString and HaxeStringView arguments are copied because the caller is free to release them as soon as we return
+		var copyArgs = signature.args.mapi((i, a) -> switch haxeFunction.rootCTypes.args[i] {
+			case Ident('HaxeString'): 'data->args.${a.name} = HaxeCBridgeInternal::copyCString(${a.name});';
+			case Ident('HaxeStringView'): 'data->args.${a.name} = HaxeCBridgeInternal::copyStringView(${a.name});';
+			case t if (isBufferCType(t)): 'data->args.${a.name} = HaxeCBridgeInternal::copyArrayView(${a.name});';
+			default: 'data->args.${a.name} = ${a.name};';
+		});
+		var freeArgs = [for (i in 0...signature.args.length) switch haxeFunction.rootCTypes.args[i] {
+			case Ident('HaxeString'): 'free((void*) data->args.${signature.args[i].name});';
+			case Ident('HaxeStringView'): 'free((void*) data->args.${signature.args[i].name}.ptr);';
+			case t if (isBufferCType(t)): 'free((void*) data->args.${signature.args[i].name}.data);';
+			default: null;
+		}].filter(line -> line != null);
+		var ticketDataTypeName = '${signature.name}_TicketData';
+
+		for (variant in haxeFunction.variants) {
+			var variantSignature = switch variant.declaration.kind {case Function(sig): sig; default: null;};
+			var variantImplementation = switch variant.kind {
+				case Batch:
+					// args are read from the caller-provided array of arg structs (which use the original argument names)
+					var argsStructType = CPrinter.printType(Pointer(Ident(originalSignature.name + '_Args', [Const])));
+					inline function callBatchElement(argsName: String, resultsName: String) {
+						var argNames = originalSignature.args.map(a -> '$argsName[i].${a.name}');
+						return hasReturnValue ?
+							'$resultsName[i] = ${callWithArgs(argNames)};' :
+							'${callWithArgs(argNames)};';
+					}
+					if (externalThread) {
+						code('
+							HAXE_C_BRIDGE_LINKAGE
+							${CPrinter.printDeclaration(variant.declaration, false)} {
+								${recordCalls('n')}
+								HaxeCBridgeInternal::ExternalThreadScope externalThreadScope;
+								${beginExecution(null)}
+								for (size_t i = 0; i < n; i++) {
+									${callBatchElement('args', 'results')}
+								}
+								${recordBatchResults}
+							}
+						');
+					} else {
+						var fnDataStruct: CStruct = {
+							fields: [
+								{name: 'n', type: Ident('size_t')},
+								{name: 'args', type: Ident(argsStructType)},
+								{name: 'results', type: hasReturnValue ? Pointer(signature.ret) : Pointer(Ident('void'))},
+								{name: 'completion', type: Pointer(Ident('HaxeCBridgeInternal::CompletionSlot'))},
+							].concat(queuedAtFields)
+						};
+						code('
+							HAXE_C_BRIDGE_LINKAGE
+							${CPrinter.printDeclaration(variant.declaration, false)} {
+								${recordCalls('n')}
+								if ($isExecutingThread) {
+									${reenterHaxe}
+									${beginExecution(null)}
+									for (size_t i = 0; i < n; i++) {
+										${callBatchElement('args', 'results')}
+									}
+									${recordBatchResults}
+									return;
+								}
+						')
+						+ indent(1, CPrinter.printDeclaration({kind: Struct('Data', fnDataStruct)}) + ';\n')
+						+ code('
+								struct Callback {
+									static void run(void* p) {
+										// executed within $executingThreadName, all calls execute within a single hop
+										Data* data = (Data*) p;
+										const size_t n = data->n;
+										$argsStructType args = data->args;
+										${hasReturnValue ? '${CPrinter.printType(Pointer(signature.ret))} results = (${CPrinter.printType(Pointer(signature.ret))}) data->results;' : ''}
+										${beginExecution('data->queuedAt')}
+										try {
+											for (size_t i = 0; i < n; i++) {
+												${callBatchElement('args', 'results')}
+											}
+											${endExecution(false)}
+											data->completion->signal();
+										} catch(Dynamic runtimeException) {
+											${endExecution(true)}
+											data->completion->signal();
+											throw runtimeException;
+										}
+									}
+								};
+
+								#ifdef HXCPP_DEBUG
+								assert(HaxeCBridgeInternal::threadRunning && "haxe thread not running, use ${namespace}_initializeHaxeThread() to activate the haxe thread");
+								#endif
+
+								if (n == 0) return;
+
+								Data data = { n, args, ${hasReturnValue ? 'results' : 'nullptr'}, &HaxeCBridgeInternal::threadCompletionSlot() };
+								data.completion->reset();
+								${setQueuedAt('data.queuedAt')}
+
+								${runCall('Callback::run', '&data')};
+								data.completion->wait();
+								${recordBatchResults}
+							}
+						');
+					}
+				case Async:
+					// arguments are copied into a pooled node that is released once the call has executed on the haxe thread
+					var asyncDeclaration: CDeclaration = {kind: Function({
+						name: variantSignature.name,
+						args: signature.args,
+						ret: Ident('void'),
+					})};
+					code('
+						HAXE_C_BRIDGE_LINKAGE
+						${CPrinter.printDeclaration(asyncDeclaration, false)} {
+							${recordCalls('1')}
+							if ($isExecutingThread) {
+								${reenterHaxe}
+								${beginExecution(null)}
+								${callWithArgs(signature.args.map(a->a.name))};
+								return;
+							}
+					')
+					+ indent(1, CPrinter.printDeclaration({kind: Struct('Data', {fields: [{name: 'args', type: InlineStruct({fields: signature.args})}].concat(queuedAtFields)})}) + ';\n')
+					+ code('
+							struct Callback {
+								static void release(Data* data) {
+									${freeArgs.join('\n\t\t\t\t\t\t\t\t\t')}
+									HaxeCBridgeInternal::NodePool<Data>::release(data);
+								}
+								static void run(void* p) {
+									// executed within $executingThreadName
+									Data* data = (Data*) p;
+									${beginExecution('data->queuedAt')}
+									try {
+										${callWithArgs(signature.args.map(a->'data->args.${a.name}'))};
+									} catch(Dynamic runtimeException) {
+										${endExecution(true)}
+										release(data);
+										// rethrow so the exception is passed to the unhandled exception callback
+										throw runtimeException;
+									}
+									${endExecution(false)}
+									release(data);
+								}
+							};
+
+							#ifdef HXCPP_DEBUG
+							assert(HaxeCBridgeInternal::threadRunning && "haxe thread not running, use ${namespace}_initializeHaxeThread() to activate the haxe thread");
+							#endif
+
+							Data* data = HaxeCBridgeInternal::NodePool<Data>::allocate();
+							${copyArgs.join('\n\t\t\t\t\t\t\t')}
+							${setQueuedAt('data->queuedAt')}
+
+							// queue a callback to execute ${haxeFunction.field.name}() on $executingThreadName without waiting for it to complete
+							${queueCall('Callback::run', 'data')};
+						}
+					');
+				case Submit:
+					var submitDeclaration: CDeclaration = {kind: Function({
+						name: variantSignature.name,
+						args: signature.args,
+						ret: variantSignature.ret,
+					})};
+					code('
+						struct $ticketDataTypeName : HaxeCBridgeInternal::Ticket {
+					')
+					+ CPrinter.printFields([
+						{name: 'args', type: InlineStruct({fields: signature.args})},
+						{name: 'ret', type: signature.ret},
+					].concat(queuedAtFields), true)
+					+ code('
+						};
+
+						HAXE_C_BRIDGE_LINKAGE
+						${CPrinter.printDeclaration(submitDeclaration, false)} {
+							typedef $ticketDataTypeName Data;
+							struct Callback {
+								static void freeArgs(Data* data) {
+									${freeArgs.join('\n\t\t\t\t\t\t\t\t\t')}
+								}
+								static void run(void* p) {
+									// executed within $executingThreadName
+									Data* data = static_cast<Data*>((HaxeCBridgeInternal::Ticket*) p);
+									${beginExecution('data->queuedAt')}
+									try {
+										data->ret = ${callWithArgs(signature.args.map(a->'data->args.${a.name}'))};
+									} catch(Dynamic runtimeException) {
+										${endExecution(true)}
+										freeArgs(data);
+										data->complete();
+										throw runtimeException;
+									}
+									${endExecution(false)}
+									freeArgs(data);
+									data->complete();
+								}
+							};
+
+							#ifdef HXCPP_DEBUG
+							assert(HaxeCBridgeInternal::threadRunning && "haxe thread not running, use ${namespace}_initializeHaxeThread() to activate the haxe thread");
+							#endif
+
+							Data* data = HaxeCBridgeInternal::NodePool<Data>::allocate();
+							data->completion.reset();
+							data->ret = {};
+							${copyArgs.join('\n\t\t\t\t\t\t\t')}
+							${setQueuedAt('data->queuedAt')}
+
+							HaxeCBridgeInternal::Ticket* ticket = data;
+							if ($isExecutingThread) {
+								${reenterHaxe}
+								try {
+									Callback::run(ticket);
+								} catch(Dynamic runtimeException) {
+									// the ticket has completed, report the exception and return the ticket so C can still release it
+									::String info = runtimeException.mPtr != nullptr ? runtimeException->toString() : HX_CSTRING("null");
+									HaxeCBridgeInternal::haxeExceptionCallback(info.utf8_str());
+								}
+							} else {
+								// queue a callback to execute ${haxeFunction.field.name}() on $executingThreadName without waiting for it to complete
+								${queueCall('Callback::run', 'ticket')};
+							}
+							return (HaxeCBridgeTicket) ticket;
+						}
+					');
+				case Result:
+					code('
+						HAXE_C_BRIDGE_LINKAGE
+						${CPrinter.printDeclaration(variant.declaration, false)} {
+							$ticketDataTypeName* data = static_cast<$ticketDataTypeName*>((HaxeCBridgeInternal::Ticket*) ticket);
+							data->completion.wait();
+							${CPrinter.printType(signature.ret)} ret = data->ret;
+							HaxeCBridgeInternal::NodePool<$ticketDataTypeName>::release(data);
+							return ${recordRetained('ret')};
+						}
+					');
+				case Into:
+					// the string is copied on the thread executing the call so it never needs to be retained
+					var bufferArgs = variantSignature.args.slice(signature.args.length);
+					var bufferArgNames = bufferArgs.map(a -> a.name).join(', ');
+					var outLenName = bufferArgs[2].name;
+					var intoDeclaration: CDeclaration = {kind: Function({
+						name: variantSignature.name,
+						args: signature.args.concat(bufferArgs),
+						ret: variantSignature.ret,
+					})};
+					inline function copyInto(argNames: Array<String>, bufferArgsPrefix: String) {
+						return 'HaxeCBridgeInternal::copyStringInto(${callWithArgs(argNames, true)}, ${bufferArgs.map(a -> bufferArgsPrefix + a.name).join(', ')})';
+					}
+					if (externalThread) {
+						code('
+							HAXE_C_BRIDGE_LINKAGE
+							${CPrinter.printDeclaration(intoDeclaration, false)} {
+								${recordCalls('1')}
+								HaxeCBridgeInternal::ExternalThreadScope externalThreadScope;
+								${beginExecution(null)}
+								return ${copyInto(signature.args.map(a -> a.name), '')};
+							}
+						');
+					} else {
+						var fnDataStruct: CStruct = {
+							fields: [
+								{name: 'args', type: InlineStruct({fields: signature.args})},
+							].concat(bufferArgs).concat([
+								{name: 'completion', type: Pointer(Ident('HaxeCBridgeInternal::CompletionSlot'))},
+								{name: 'ret', type: Ident('bool')},
+							]).concat(queuedAtFields)
+						};
+						code('
+							HAXE_C_BRIDGE_LINKAGE
+							${CPrinter.printDeclaration(intoDeclaration, false)} {
+								${recordCalls('1')}
+								if ($isExecutingThread) {
+									${reenterHaxe}
+									${beginExecution(null)}
+									return ${copyInto(signature.args.map(a -> a.name), '')};
+								}
+						')
+						+ indent(1, CPrinter.printDeclaration({kind: Struct('Data', fnDataStruct)}) + ';\n')
+						+ code('
+								struct Callback {
+									static void run(void* p) {
+										// executed within $executingThreadName
+										Data* data = (Data*) p;
+										${beginExecution('data->queuedAt')}
+										try {
+											data->ret = ${copyInto(signature.args.map(a -> 'data->args.${a.name}'), 'data->')};
+											${endExecution(false)}
+											data->completion->signal();
+										} catch(Dynamic runtimeException) {
+											${endExecution(true)}
+											data->completion->signal();
+											throw runtimeException;
+										}
+									}
+								};
+
+								#ifdef HXCPP_DEBUG
+								assert(HaxeCBridgeInternal::threadRunning && "haxe thread not running, use ${namespace}_initializeHaxeThread() to activate the haxe thread");
+								#endif
+
+								// report an empty string if the call throws
+								if ($outLenName != nullptr) *$outLenName = 0;
+
+								Data data = { {${signature.args.map(a -> a.name).join(', ')}}, $bufferArgNames, &HaxeCBridgeInternal::threadCompletionSlot(), false };
+								data.completion->reset();
+								${setQueuedAt('data.queuedAt')}
+
+								${runCall('Callback::run', '&data')};
+								data.completion->wait();
+								return data.ret;
+							}
+						');
+					}
+			}
+			implementation += '\n' + variantImplementation;
+		}
+
+		return implementation;
+	}
+
+	/**
+		Create additional non-blocking C functions which queue a call on the haxe thread and return immediately
+
+		For Void functions this is a fire-and-forget `{FunctionName}_async()`
+		For functions that return a value, `{FunctionName}_submit()` returns a ticket which is redeemed with `{FunctionName}_result()`
+	**/
+	static function createAsyncVariants(ctx: CConverterContext, declaration: CDeclaration, f: ClassField): Array<FunctionVariant> {
+		var signature = switch declaration.kind {case Function(sig): sig; default: null;};
+		if (f.meta.has('externalThread')) {
+			Context.error('@async cannot be combined with @externalThread', f.pos);
+		}
+
+		if (signature.ret.match(Ident('void'))) {
+			var name = signature.name + '_async';
+			ctx.declareFunctionIdentifier(name, f.pos);
+			return [{
+				kind: Async,
+				declaration: {
+					doc: code('
+						Non-blocking version of `${signature.name}()`: queues the call to execute on the haxe thread and returns immediately
+
+						String arguments are copied so they may be freed as soon as this function returns
+						Unhandled exceptions are passed to the `HaxeExceptionCallback`
+
+						Thread-safety: can be called on any thread. Calls made from the same thread execute in order'),
+					kind: Function({
+						name: name,
+						args: signature.args,
+						ret: Ident('void'),
+					})
+				}
+			}];
+		} else {
+			var ticketType = ctx.getTicketCType();
+			var submitName = signature.name + '_submit';
+			var resultName = signature.name + '_result';
+			ctx.declareFunctionIdentifier(submitName, f.pos);
+			ctx.declareFunctionIdentifier(resultName, f.pos);
+			return [{
+				kind: Submit,
+				declaration: {
+					doc: code('
+						Non-blocking version of `${signature.name}()`: queues the call to execute on the haxe thread and returns a ticket immediately
+
+						Use `${resultName}()` to wait for and collect the return value (this also frees the ticket)
+						String arguments are copied so they may be freed as soon as this function returns
+
+						Thread-safety: can be called on any thread. Calls made from the same thread execute in order'),
+					kind: Function({
+						name: submitName,
+						args: signature.args,
+						ret: ticketType,
+					})
+				}
+			}, {
+				kind: Result,
+				declaration: {
+					doc: code('
+						Waits for a call queued with `${submitName}()` to complete and returns its return value. The ticket is freed and must not be used again
+
+						If the call threw an unhandled exception the returned value is zero-initialized
+						Returned haxe objects and strings are retained in the same way as `${signature.name}()`
+
+						Thread-safety: can be called on any thread
+
+						@param ticket a ticket returned from `${submitName}()`'),
+					kind: Function({
+						name: resultName,
+						args: [{name: 'ticket', type: ticketType}],
+						ret: signature.ret,
+					})
+				}
+			}];
+		}
+	}
+
+	/**
+		Create an additional C function which executes `n` calls of the function in a single hop to the haxe thread
+
+		Arguments are passed as an array of `{FunctionName}_Args` structs
+	**/
+	static function createBatchVariant(ctx: CConverterContext, declaration: CDeclaration, pos: Position): FunctionVariant {
+		var signature = switch declaration.kind {case Function(sig): sig; default: null;};
+		if (signature.args.length == 0) {
+			Context.error('@batch requires the function to have at least one argument', pos);
+		}
+		ctx.requireHeader('stddef.h');
+
+		var argsTypeName = signature.name + '_Args';
+		ctx.addTypedefDeclaration(argsTypeName, InlineStruct({fields: signature.args}));
+
+		var hasReturnValue = !signature.ret.match(Ident('void'));
+		var name = signature.name + '_batch';
+		ctx.declareFunctionIdentifier(name, pos);
+
+		return {
+			kind: Batch,
+			declaration: {
+				doc: code('
+					Executes `${signature.name}()` `n` times in a single hop to the haxe thread
+					${hasReturnValue ? '
+					The return value of call `i` is written to `results[i]`' : ''}
+					If a call throws an unhandled exception the remaining calls are not executed
+
+					@param n number of calls to execute
+					@param args array of `n` argument structs${hasReturnValue ? '
+					@param results array with space for `n` return values' : ''}'),
+				kind: Function({
+					name: name,
+					args: [
+						{name: 'n', type: Ident('size_t')},
+						{name: 'args', type: Pointer(Ident(argsTypeName, [Const]))},
+					].concat(hasReturnValue ? [
+						{name: 'results', type: Pointer(signature.ret)}
+					] : []),
+					ret: Ident('void'),
+				})
+			}
+		}
+	}
+
+	/**
+		Create an additional C function for functions returning strings, which copies the string into a caller-provided buffer rather than returning a retained handle
+	**/
+	static function createIntoVariant(ctx: CConverterContext, declaration: CDeclaration, pos: Position): FunctionVariant {
+		var signature = switch declaration.kind {case Function(sig): sig; default: null;};
+		ctx.requireHeader('stdbool.h');
+		ctx.requireHeader('stddef.h');
+
+		var name = signature.name + '_into';
+		ctx.declareFunctionIdentifier(name, pos);
+
+		// avoid conflicts with the names of the original arguments
+		var argNames = signature.args.map(a -> a.name);
+		inline function argName(name: String) {
+			return argNames.has(name) ? name + '_' : name;
+		}
+
+		return {
+			kind: Into,
+			declaration: {
+				doc: code('
+					Copies the string returned by `${signature.name}()` into `buf` as null-terminated UTF-8. The string is not retained so there is nothing to release
+
+					@param buf buffer to receive the string, may be `NULL` if `cap` is 0
+					@param cap size of `buf` in bytes
+					@param outLen receives the length of the complete string in bytes (excluding the null terminator), may be `NULL`. A null string has length 0
+					@returns `true` if the complete string fit in `buf`. Otherwise the string is truncated at a character boundary (and null-terminated if `cap` is not 0), call again with a buffer of at least `*outLen + 1` bytes to receive the complete string. If the call throws an unhandled exception `false` is returned and `*outLen` is 0'),
+				kind: Function({
+					name: name,
+					args: signature.args.concat([
+						{name: argName('buf'), type: Pointer(Ident('char'))},
+						{name: argName('cap'), type: Ident('size_t')},
+						{name: argName('outLen'), type: Pointer(Ident('size_t'))},
+					]),
+					ret: Ident('bool'),
+				})
+			}
+		}
 	}
 
 	/**
@@ -866,6 +3547,22 @@ enum FunctionInfoKind {
 	Static;
 }
 
+/**
+	Additional C functions generated alongside an exposed function
+**/
+enum FunctionVariantKind {
+	Batch;
+	Async;
+	Submit;
+	Result;
+	Into;
+}
+
+typedef FunctionVariant = {
+	kind: FunctionVariantKind,
+	declaration: CDeclaration,
+}
+
 enum CModifier {
 	Const;
 }
@@ -1062,8 +3759,8 @@ class CConverterContext {
 		declareFunctionIdentifier(name, pos);
 	}
 
-	public function addTypedFunctionDeclaration(name: String, tfunc: TFunc, doc: Null<String>, pos: Position) {
-		functionDeclarations.push({
+	public function addTypedFunctionDeclaration(name: String, tfunc: TFunc, doc: Null<String>, pos: Position): CDeclaration {
+		var declaration: CDeclaration = {
 			doc: doc,
 			kind: Function({
 				name: name,
@@ -1073,11 +3770,24 @@ class CConverterContext {
 				}),
 				ret: convertType(tfunc.t, true, false, pos)
 			})
-		});
+		};
+		functionDeclarations.push(declaration);
 		declareFunctionIdentifier(name, pos);
+		return declaration;
+	}
+
+	/**
+		Declare a named typedef, if one with the same identifier has not already been declared
+	**/
+	public function addTypedefDeclaration(ident: String, type: CType, ?doc: String): CType {
+		if (!declaredTypeIdentifiers.exists(ident)) {
+			typeDeclarations.push({kind: Typedef(type, [ident]), doc: doc});
+			declaredTypeIdentifiers.set(ident, true);
+		}
+		return Ident(ident);
 	}
 
-	function declareFunctionIdentifier(name: String, pos: Position) {
+	public function declareFunctionIdentifier(name: String, pos: Position) {
 		var existingDecl = declaredFunctionIdentifiers.get(name);
 		if (existingDecl == null) {
 			declaredFunctionIdentifiers.set(name, pos);
@@ -1173,7 +3883,11 @@ class CConverterContext {
 				}
 
 			case TAnonymous(a):
-				if (allowNonTrivial) {
+				var structCType = allowNonTrivial ? tryGetAnonStructCType(a.get(), pos) : null;
+				if (structCType != null) {
+					// structures of numbers are copied into a C struct
+					structCType;
+				} else if (allowNonTrivial) {
 					getHaxeObjectCType(type);
 				} else {
 					Context.error('Structures are not supported as secondary type for C export, use HaxeCBridge.HaxeObject<T> instead', pos);
@@ -1273,8 +3987,19 @@ class CConverterContext {
 					// Null<T> isn't supported, so we convert T instead
 					convertType(tp, allowNonTrivial, allowBareFnTypes, pos);
 
-				case {t: {pack: [], name: "Array"}}:
-					Context.error("Array<T> is not supported for C export, try using cpp.Pointer<T> instead", pos);
+				case {t: {pack: [], name: "Array"}, params: [tp]}:
+					// arrays of numbers are passed as a pointer to the array storage
+					var rootElementCType = new CConverterContext({generateTypedef: false, generateTypedefForFunctions: false, generateEnums: false}).convertType(tp, false, false, pos);
+					var isNumeric = switch rootElementCType {
+						case Ident(name, null | []): arrayElementCTypeNames.has(name);
+						default: false;
+					}
+					if (!isNumeric) {
+						Context.error('Array<${TypeTools.toString(tp)}> is not supported for C export, only arrays of numbers are supported. Try using cpp.Pointer<T> instead', pos);
+					} else if (!allowNonTrivial) {
+						Context.error('Array<${TypeTools.toString(tp)}> is not supported as secondary type for C export', pos);
+					}
+					getHaxeArrayCType(type, rootElementCType);
 
 				case {t: {pack: [], name: 'Void' | 'void'}}: Ident('void');
 				case {t: {pack: [], name: "Bool"}}: requireHeader('stdbool.h'); Ident("bool");
@@ -1301,6 +4026,20 @@ class CConverterContext {
 
 				// non-trivial types
 				// hxcpp will convert these automatically if primary type but not if secondary (like as argument type or pointer type)
+				case {t: {pack: [], module: "HaxeCBridge", name: "HaxeStringView"}}:
+					if (allowNonTrivial) {
+						getHaxeStringViewCType(type);
+					} else {
+						Context.error('HaxeCBridge.HaxeStringView is not supported as secondary type for C export', pos);
+					}
+
+				case {t: {pack: ['haxe', 'io'], name: "Bytes"}}:
+					if (allowNonTrivial) {
+						getHaxeBytesCType(type);
+					} else {
+						Context.error('haxe.io.Bytes is not supported as secondary type for C export', pos);
+					}
+
 				case {t: {pack: [], name: "String"}}:
 					if (allowNonTrivial) {
 						getHaxeStringCType(type);
@@ -1493,6 +4232,7 @@ class CConverterContext {
 					Informs the garbage collector that object is no longer needed by the C code.
 
 					If the object has no remaining reference the garbage collector can free the associated memory (which can happen at any time in the future). It does not free the memory immediately.
+					Releases from other threads are deferred: they are applied in bulk the next time the haxe thread processes calls from C and do not wake the haxe thread.
 
 					Thread-safety: can be called on any thread.
 
@@ -1503,44 +4243,272 @@ class CConverterContext {
 					ret: Ident('void')
 				})
 			});
-			supportDeclaredFunctionIdentifiers.set(functionIdent, Context.currentPos());
+			supportDeclaredFunctionIdentifiers.set(functionIdent, Context.currentPos());
+		}
+
+		var bulkFunctionIdent = functionIdent + 's';
+		if (!supportDeclaredFunctionIdentifiers.exists(bulkFunctionIdent)) {
+			requireHeader('stddef.h');
+			supportFunctionDeclarations.push({
+				doc: code('
+					Releases `count` objects in a single visit to the haxe thread, this is equivalent to calling `${functionIdent}()` for each element
+
+					The array is copied so it can be freed as soon as this function returns
+
+					Thread-safety: can be called on any thread.
+
+					@param haxeObjects array of handles returned from haxe functions
+					@param count number of elements in `haxeObjects`'),
+				kind: Function({
+					name: bulkFunctionIdent,
+					args: [{name: 'haxeObjects', type: Pointer(Ident(typeIdent, [Const]))}, {name: 'count', type: Ident('size_t')}],
+					ret: Ident('void')
+				})
+			});
+			supportDeclaredFunctionIdentifiers.set(bulkFunctionIdent, Context.currentPos());
+		}
+
+		return Ident(typeIdent);
+	}
+
+	public function getTicketCType(): CType {
+		var typeIdent = 'HaxeCBridgeTicket';
+		var waitFunctionIdent = '${declarationPrefix}_waitTicket';
+		var pollFunctionIdent = '${declarationPrefix}_pollTicket';
+
+		if (!supportDeclaredTypeIdentifiers.exists(typeIdent)) {
+			supportTypeDeclarations.push({
+				kind: Typedef(Pointer(Ident('void')), [typeIdent]),
+				doc: code('
+					Represents a call queued on the haxe thread by a `_submit()` function
+					The return value is collected with the matching `_result()` function, which also frees the ticket')
+			});
+			supportDeclaredTypeIdentifiers.set(typeIdent, true);
+		}
+
+		if (!supportDeclaredFunctionIdentifiers.exists(waitFunctionIdent)) {
+			requireHeader('stdbool.h');
+			supportFunctionDeclarations.push({
+				doc: code('
+					Blocks until the call behind a ticket has completed. The ticket remains valid until passed to its `_result()` function
+
+					Thread-safety: can be called on any thread, however only one thread may wait on a ticket at a time
+
+					@param ticket a ticket returned from a `_submit()` function'),
+				kind: Function({
+					name: waitFunctionIdent,
+					args: [{name: 'ticket', type: Ident(typeIdent)}],
+					ret: Ident('void')
+				})
+			});
+			supportDeclaredFunctionIdentifiers.set(waitFunctionIdent, Context.currentPos());
+
+			supportFunctionDeclarations.push({
+				doc: code('
+					Returns `true` if the call behind a ticket has completed (in which case its `_result()` function will return without blocking)
+
+					Thread-safety: can be called on any thread
+
+					@param ticket a ticket returned from a `_submit()` function'),
+				kind: Function({
+					name: pollFunctionIdent,
+					args: [{name: 'ticket', type: Ident(typeIdent)}],
+					ret: Ident('bool')
+				})
+			});
+			supportDeclaredFunctionIdentifiers.set(pollFunctionIdent, Context.currentPos());
+		}
+
+		return Ident(typeIdent);
+	}
+
+	function getHaxeStringCType(t: Type): CType {
+		// in the future we could specialize based on t (i.e. generating another typedef name like HaxeObject_SomeType)
+		var typeIdent = 'HaxeString';
+		var functionIdent = '${declarationPrefix}_releaseHaxeString';
+
+		if (!supportDeclaredTypeIdentifiers.exists(typeIdent)) {
+			supportTypeDeclarations.push({
+				kind: Typedef(Pointer(Ident("char", [Const])), [typeIdent]),
+				doc: code('
+					Internally haxe strings are stored as null-terminated C strings. Cast to char16_t if you expect utf16 strings.
+					When passed from haxe to C, a reference to the object is retained to prevent garbage collection. You should call releaseHaxeString() when finished with this handle to allow collection.')
+			});
+			supportDeclaredTypeIdentifiers.set(typeIdent, true);
+		}
+
+		if (!supportDeclaredFunctionIdentifiers.exists(functionIdent)) {
+			supportFunctionDeclarations.push({
+				doc: code('
+					Informs the garbage collector that the string is no longer needed by the C code.
+
+					If the object has no remaining reference the garbage collector can free the associated memory (which can happen at any time in the future). It does not free the memory immediately.
+					Releases from other threads are deferred: they are applied in bulk the next time the haxe thread processes calls from C and do not wake the haxe thread.
+
+					Thread-safety: can be called on any thread.
+
+					@param haxeString a handle to a haxe string returned from a haxe function'),
+				kind: Function({
+					name: functionIdent,
+					args: [{name: 'haxeString', type: Ident(typeIdent)}],
+					ret: Ident('void')
+				})
+			});
+			supportDeclaredFunctionIdentifiers.set(functionIdent, Context.currentPos());
+		}
+
+		var bulkFunctionIdent = functionIdent + 's';
+		if (!supportDeclaredFunctionIdentifiers.exists(bulkFunctionIdent)) {
+			requireHeader('stddef.h');
+			supportFunctionDeclarations.push({
+				doc: code('
+					Releases `count` strings in a single visit to the haxe thread, this is equivalent to calling `${functionIdent}()` for each element
+
+					The array is copied so it can be freed as soon as this function returns
+
+					Thread-safety: can be called on any thread.
+
+					@param haxeStrings array of handles returned from haxe functions
+					@param count number of elements in `haxeStrings`'),
+				kind: Function({
+					name: bulkFunctionIdent,
+					args: [{name: 'haxeStrings', type: Pointer(Ident(typeIdent, [Const]))}, {name: 'count', type: Ident('size_t')}],
+					ret: Ident('void')
+				})
+			});
+			supportDeclaredFunctionIdentifiers.set(bulkFunctionIdent, Context.currentPos());
+		}
+
+		return Ident(typeIdent);
+	}
+
+	// C types of the array elements that can be passed as HaxeArray_ structs, these match the element types hxcpp uses
+	static final arrayElementCTypeNames = ['int', 'double', 'float', 'signed char', 'unsigned char', 'short', 'unsigned short', 'unsigned int', 'int64_t', 'uint64_t'];
+
+	// element type of each HaxeArray_ typedef
+	public static final arrayElementCTypes = new Map<String, CType>();
+
+	function getHaxeArrayCType(t: Type, elementCType: CType): CType {
+		var elementName = CPrinter.printType(elementCType);
+		var typeIdent = 'HaxeArray_' + elementName.replace(' ', '_');
+
+		// the owner is released with releaseHaxeObject()
+		var ownerCType = getHaxeObjectCType(t);
+
+		if (!supportDeclaredTypeIdentifiers.exists(typeIdent)) {
+			requireHeader('stddef.h');
+			supportTypeDeclarations.push({
+				kind: Typedef(InlineStruct({fields: [
+					{name: 'data', type: Pointer(elementCType)},
+					{name: 'length', type: Ident('size_t')},
+					{name: 'owner', type: ownerCType},
+				]}), [typeIdent]),
+				doc: code('
+					A haxe Array of `${elementName}` passed as a pointer to its elements and the number of elements, without copying
+					When passed from haxe to C, `data` points directly at the array storage and `owner` is a retained handle to the array. You should call releaseHaxeObject(array.owner) when finished with the array to allow collection. Changing the length of the array in haxe invalidates `data`
+					When passed from C to haxe, if `owner` is not `NULL` the haxe function receives the array it refers to. Otherwise the haxe array uses the memory at `data` directly for the duration of the call, so haxe code must not keep a reference to it')
+			});
+			supportDeclaredTypeIdentifiers.set(typeIdent, true);
+			arrayElementCTypes.set(typeIdent, elementCType);
+		}
+
+		return Ident(typeIdent);
+	}
+
+	/**
+		Fields of the C structs generated for anonymous structures, by C type identifier (see tryGetAnonStructCType())
+		`haxeName` is the name of the haxe field and `name` is the name of the C field
+	**/
+	public static final anonStructs = new Map<String, Array<{haxeName: String, name: String, type: CType}>>();
+
+	/**
+		Anonymous structures where every field is a number or Bool are passed by value as a C struct, otherwise this returns null
+
+		The struct is named by its fields so the same structure always maps to the same C type, typedefs of the structure are declared as aliases of this type
+	**/
+	function tryGetAnonStructCType(a: AnonType, pos: Position): Null<CType> {
+		if (a.fields.length == 0) return null;
+
+		// keep declaration order
+		var haxeFields = a.fields.copy();
+		haxeFields.sort((x, y) -> Context.getPosInfos(x.pos).min - Context.getPosInfos(y.pos).min);
+
+		var fields = new Array<{haxeName: String, name: String, type: CType}>();
+		for (field in haxeFields) {
+			if (field.meta.has(':optional') || !field.kind.match(FVar(_, _))) return null;
+			var rootCType = new CConverterContext({generateTypedef: false, generateTypedefForFunctions: false, generateEnums: false}).convertType(field.type, false, false, pos);
+			var isValueType = switch rootCType {
+				case Ident(name, null | []): name == 'bool' || arrayElementCTypeNames.has(name);
+				default: false;
+			}
+			if (!isValueType) return null;
+			fields.push({
+				haxeName: field.name,
+				name: cKeywords.has(field.name) ? field.name + '_' : field.name,
+				type: rootCType,
+			});
 		}
 
-		return Ident(typeIdent);
+		var key = safeIdent('Struct_' + fields.map(f -> f.name + '_' + CPrinter.printType(f.type)).join('_'));
+		var ident = declarationPrefix != '' ? declarationPrefix + '_' + key : key;
+
+		if (!declaredTypeIdentifiers.exists(ident)) {
+			if (fields.exists(f -> f.type.match(Ident('bool')))) requireHeader('stdbool.h');
+			if (fields.exists(f -> f.type.match(Ident('int64_t' | 'uint64_t')))) requireHeader('stdint.h');
+			typeDeclarations.push({kind: Typedef(InlineStruct({fields: fields.map(f -> {name: f.name, type: f.type})}), [ident])});
+			declaredTypeIdentifiers.set(ident, true);
+		}
+		anonStructs.set(ident, fields);
+
+		return Ident(ident);
 	}
 
-	function getHaxeStringCType(t: Type): CType {
-		// in the future we could specialize based on t (i.e. generating another typedef name like HaxeObject_SomeType)
-		var typeIdent = 'HaxeString';
-		var functionIdent = '${declarationPrefix}_releaseHaxeString';
+	function getHaxeBytesCType(t: Type): CType {
+		var typeIdent = 'HaxeBytes';
+
+		// the owner is released with releaseHaxeObject()
+		var ownerCType = getHaxeObjectCType(t);
+		requireImplementationHeader('haxe/io/Bytes.h');
 
 		if (!supportDeclaredTypeIdentifiers.exists(typeIdent)) {
+			requireHeader('stddef.h');
 			supportTypeDeclarations.push({
-				kind: Typedef(Pointer(Ident("char", [Const])), [typeIdent]),
+				kind: Typedef(InlineStruct({fields: [
+					{name: 'data', type: Pointer(Ident('unsigned char'))},
+					{name: 'length', type: Ident('size_t')},
+					{name: 'owner', type: ownerCType},
+				]}), [typeIdent]),
 				doc: code('
-					Internally haxe strings are stored as null-terminated C strings. Cast to char16_t if you expect utf16 strings.
-					When passed from haxe to C, a reference to the object is retained to prevent garbage collection. You should call releaseHaxeString() when finished with this handle to allow collection.')
+					A haxe.io.Bytes passed as a pointer to its bytes and the length in bytes, without copying
+					When passed from haxe to C, `data` points directly at the storage of the Bytes and `owner` is a retained handle to the Bytes. You should call releaseHaxeObject(bytes.owner) when finished with the bytes to allow collection
+					When passed from C to haxe, if `owner` is not `NULL` the haxe function receives the Bytes it refers to. Otherwise the haxe Bytes uses the memory at `data` directly for the duration of the call, so haxe code must not keep a reference to it')
 			});
 			supportDeclaredTypeIdentifiers.set(typeIdent, true);
 		}
 
-		if (!supportDeclaredFunctionIdentifiers.exists(functionIdent)) {
-			supportFunctionDeclarations.push({
-				doc: code('
-					Informs the garbage collector that the string is no longer needed by the C code.
+		return Ident(typeIdent);
+	}
 
-					If the object has no remaining reference the garbage collector can free the associated memory (which can happen at any time in the future). It does not free the memory immediately.
+	function getHaxeStringViewCType(t: Type): CType {
+		var typeIdent = 'HaxeStringView';
 
-					Thread-safety: can be called on any thread.
+		// views are released with releaseHaxeString()
+		getHaxeStringCType(t);
 
-					@param haxeString a handle to a haxe string returned from a haxe function'),
-				kind: Function({
-					name: functionIdent,
-					args: [{name: 'haxeString', type: Ident(typeIdent)}],
-					ret: Ident('void')
-				})
+		if (!supportDeclaredTypeIdentifiers.exists(typeIdent)) {
+			requireHeader('stddef.h');
+			supportTypeDeclarations.push({
+				kind: Typedef(InlineStruct({fields: [
+					{name: 'ptr', type: Pointer(Ident('char', [Const]))},
+					{name: 'length', type: Ident('size_t')},
+				]}), [typeIdent]),
+				doc: code('
+					A haxe string passed to C as its null-terminated UTF-8 bytes and its length in bytes (excluding the null terminator), so there is no need to call strlen()
+					`ptr` points directly at the haxe string buffer unless the string is stored as UTF-16, in which case the conversion is cached so returning the same string again does not re-encode it
+					When passed from haxe to C, a reference to the string is retained to prevent garbage collection. You should call releaseHaxeString(view.ptr) when finished with the view to allow collection.
+					When passed from C to haxe, `ptr` does not need to be null-terminated and only `length` bytes are read')
 			});
-			supportDeclaredFunctionIdentifiers.set(functionIdent, Context.currentPos());
+			supportDeclaredTypeIdentifiers.set(typeIdent, true);
 		}
 
 		return Ident(typeIdent);
@@ -1590,7 +4558,7 @@ class CConverterContext {
 		"auto", "double", "int", "struct", "break", "else", "long", "switch", "case", "enum", "register", "typedef", "char", "extern", "return", "union", "const", "float", "short", "unsigned", "continue", "for", "signed", "void", "default", "goto", "sizeof", "volatile", "do", "if", "static", "while",
 		"size_t", "int64_t", "uint64_t",
 		// HaxeCBridge types
-		"HaxeObject", "HaxeExceptionCallback",
+		"HaxeObject", "HaxeStringView", "HaxeBytes", "HaxeExceptionCallback", "HaxeCBridgeTicket", "HaxeCBridgeNativeCallCounters", "HaxeCBridgeFunctionStats",
 		// hxcpp
 		"Int", "String", "Float", "Dynamic", "Bool",
 	];
@@ -1674,9 +4642,237 @@ abstract HaxeObject<T: {}>(cpp.RawPointer<cpp.Void>) from cpp.RawPointer<cpp.Voi
 	}
 }
 
+/**
+	Return a string as `HaxeStringView` rather than `HaxeString` to pass C its length along with the pointer
+**/
+@:forward
+abstract HaxeStringView(String) from String to String {}
+
 @:nativeGen
 @:keep
 @:noCompletion
+@:cppFileCode('
+	#include <atomic>
+	#include <mutex>
+
+	/**
+	 * Maps retained pointers to slots in the retained values array, which is the only GC root for retained values
+	 *
+	 * Reference counts and the pointer index are kept outside of the GC heap so retain and release do not allocate once the table has grown
+	 * Only accessed from the haxe main thread, unless lanes are running (see HaxeCBridgeRetainLock)
+	 */
+	struct HaxeCBridgeRetainTable {
+		struct Entry {
+			const void* key; // nullptr for empty, tombstone() for removed
+			int slot;
+		};
+
+		Entry* entries;
+		size_t capacity; // power of two
+		size_t occupied; // entries with a key or a tombstone
+
+		int* refCounts; // indexed by slot
+		int* freeSlots;
+		int freeCount;
+		int slotCount; // number of slots handed out, slots below this are either retained or in freeSlots
+		int slotCapacity;
+
+		HaxeCBridgeRetainTable(): entries(nullptr), capacity(0), occupied(0), refCounts(nullptr), freeSlots(nullptr), freeCount(0), slotCount(0), slotCapacity(0) {}
+
+		static const void* tombstone() {
+			return (const void*) 1;
+		}
+
+		static size_t hash(const void* key) {
+			// pointers are aligned so mix the bits (murmur3 finalizer)
+			uint64_t x = (uint64_t) (uintptr_t) key;
+			x ^= x >> 33;
+			x *= 0xff51afd7ed558ccdULL;
+			x ^= x >> 33;
+			return (size_t) x;
+		}
+
+		Entry* find(const void* key) {
+			if (capacity == 0 || key == nullptr || key == tombstone()) return nullptr;
+			size_t mask = capacity - 1;
+			for (size_t i = hash(key) & mask;; i = (i + 1) & mask) {
+				Entry* entry = &entries[i];
+				if (entry->key == key) return entry;
+				if (entry->key == nullptr) return nullptr;
+			}
+		}
+
+		void insert(const void* key, int slot) {
+			if ((occupied + 1) * 4 > capacity * 3) {
+				rehash();
+			}
+			size_t mask = capacity - 1;
+			size_t i = hash(key) & mask;
+			while (entries[i].key != nullptr && entries[i].key != tombstone()) {
+				i = (i + 1) & mask;
+			}
+			if (entries[i].key == nullptr) occupied++;
+			entries[i].key = key;
+			entries[i].slot = slot;
+		}
+
+		void rehash() {
+			Entry* oldEntries = entries;
+			size_t oldCapacity = capacity;
+			// grow if live entries are filling the table, otherwise only clear tombstones
+			size_t live = (size_t) (slotCount - freeCount);
+			capacity = capacity == 0 ? 256 : capacity;
+			while ((live + 1) * 2 > capacity) capacity *= 2;
+			entries = (Entry*) calloc(capacity, sizeof(Entry));
+			occupied = 0;
+			size_t mask = capacity - 1;
+			for (size_t j = 0; j < oldCapacity; j++) {
+				const void* key = oldEntries[j].key;
+				if (key == nullptr || key == tombstone()) continue;
+				size_t i = hash(key) & mask;
+				while (entries[i].key != nullptr) i = (i + 1) & mask;
+				entries[i] = oldEntries[j];
+				occupied++;
+			}
+			free(oldEntries);
+		}
+
+		// increments the reference count of key and returns its slot, null is never retained and returns -1
+		int retain(const void* key) {
+			if (key == nullptr) return -1;
+			Entry* entry = find(key);
+			if (entry != nullptr) {
+				refCounts[entry->slot]++;
+				return entry->slot;
+			}
+			int slot;
+			if (freeCount > 0) {
+				slot = freeSlots[--freeCount];
+			} else {
+				if (slotCount == slotCapacity) {
+					slotCapacity = slotCapacity == 0 ? 256 : slotCapacity * 2;
+					refCounts = (int*) realloc(refCounts, sizeof(int) * slotCapacity);
+					freeSlots = (int*) realloc(freeSlots, sizeof(int) * slotCapacity);
+				}
+				slot = slotCount++;
+			}
+			refCounts[slot] = 1;
+			insert(key, slot);
+			return slot;
+		}
+
+		// decrements the reference count of key, returns its slot if this was the last reference (so the value can be cleared) or -1 otherwise
+		int release(const void* key) {
+			Entry* entry = find(key);
+			if (entry == nullptr) return -1;
+			int slot = entry->slot;
+			if (--refCounts[slot] > 0) return -1;
+			entry->key = tombstone();
+			freeSlots[freeCount++] = slot;
+			return slot;
+		}
+	};
+
+	static HaxeCBridgeRetainTable haxeCBridgeRetainTable;
+
+	// set by HaxeCBridge.shareRetainTable() before lane threads start, until then the table is only accessed from the haxe main thread
+	static std::atomic<bool> haxeCBridgeRetainTableShared(false);
+	static std::recursive_mutex haxeCBridgeRetainTableMutex;
+
+	// true while the thread is parked in a GC-free zone that calls into haxe must leave: during a @gcFreeCallback, or on the inline host thread between pumps
+	thread_local bool haxeCBridgeInGCFreeZone = false;
+
+	// locks the retain table for the current scope when it is shared between threads
+	struct HaxeCBridgeRetainLock {
+		bool locked;
+
+		HaxeCBridgeRetainLock(): locked(haxeCBridgeRetainTableShared.load(std::memory_order_relaxed)) {
+			if (!locked) return;
+			if (!haxeCBridgeRetainTableMutex.try_lock()) {
+				// wait outside of the GC so a collection started by the thread holding the lock can complete
+				hx::EnterGCFreeZone();
+				haxeCBridgeRetainTableMutex.lock();
+				hx::ExitGCFreeZone();
+			}
+		}
+
+		~HaxeCBridgeRetainLock() {
+			if (locked) haxeCBridgeRetainTableMutex.unlock();
+		}
+	};
+
+	// strings stored as UTF-16 must be converted before they can be passed to C as UTF-8
+	static inline bool haxeCBridgeIsUTF16(const ::String& str) {
+		#ifdef HX_SMART_STRINGS
+		return str.isUTF16Encoded();
+		#else
+		return false;
+		#endif
+	}
+
+	/**
+	 * Contents of the strings in the intern cache (see HaxeCBridge.internString()), the strings themselves are kept in Internal.internedStrings
+	 *
+	 * Direct-mapped by a hash of the contents so a lookup is a hash and a compare, and the cache never grows
+	 * Only accessed from the haxe main thread
+	 */
+	struct HaxeCBridgeInternTable {
+		static const int size = 256; // power of two
+		static const size_t maxLength = 128; // longer strings are not interned
+
+		struct Entry {
+			uint64_t hash;
+			size_t length;
+			char* bytes; // nullptr if the slot is empty
+		};
+
+		Entry entries[size];
+
+		HaxeCBridgeInternTable() {
+			memset(entries, 0, sizeof(entries));
+		}
+
+		static uint64_t hash(const char* ptr, size_t length) {
+			// FNV-1a
+			uint64_t h = 0xcbf29ce484222325ULL;
+			for (size_t i = 0; i < length; i++) {
+				h ^= (unsigned char) ptr[i];
+				h *= 0x100000001b3ULL;
+			}
+			return h;
+		}
+
+		// returns the slot holding a string with these contents or -1 if there is none
+		int find(const char* ptr, int length) {
+			if (ptr == nullptr || (size_t) length > maxLength) return -1;
+			uint64_t h = hash(ptr, length);
+			int slot = (int) (h & (size - 1));
+			Entry& entry = entries[slot];
+			bool matches = entry.bytes != nullptr && entry.hash == h && entry.length == (size_t) length && memcmp(entry.bytes, ptr, length) == 0;
+			return matches ? slot : -1;
+		}
+
+		// records these contents in their slot (replacing any previous string) and returns the slot, or -1 if the string is not interned
+		int insert(const char* ptr, int length) {
+			if (ptr == nullptr || (size_t) length > maxLength) return -1;
+			uint64_t h = hash(ptr, length);
+			int slot = (int) (h & (size - 1));
+			Entry& entry = entries[slot];
+			entry.bytes = (char*) realloc(entry.bytes, length > 0 ? length : 1);
+			memcpy(entry.bytes, ptr, length);
+			entry.hash = h;
+			entry.length = length;
+			return slot;
+		}
+	};
+
+	static HaxeCBridgeInternTable haxeCBridgeInternTable;
+
+	// index into the string view conversion cache, keyed by the identity of the string buffer
+	static inline int haxeCBridgeStringViewCacheIndex(const ::String& str, int cacheSize) {
+		return (int) ((HaxeCBridgeRetainTable::hash(str.raw_ptr())) & (size_t) (cacheSize - 1));
+	}
+')
 class HaxeCBridge {
 
 	#if (haxe_ver >= 4.2)
@@ -1688,76 +4884,141 @@ class HaxeCBridge {
 		#end
 
 		Internal.isMainThreadCb = isMainThreadCb;
-		Internal.mainThreadWaitLock = Thread.current().events.waitLock;
+		Internal.mainLoop = new EventLoopState(Thread.current().events.waitLock);
 
 		#if (haxe_ver < 4.201)
 		EntryPoint.init();
 		#end
 	}
 
+	/**
+		Creates an event loop for lane `lane` on the calling thread, `lanesInit()` must have been called on the haxe main thread first
+	**/
 	@:noCompletion
-	static public function mainThreadRun(
+	static public function laneThreadInit(lane: Int) @:privateAccess {
+		Thread.initEventLoop();
+		Internal.laneLoops[lane] = new EventLoopState(Thread.current().events.waitLock);
+	}
+
+	@:noCompletion
+	static public function laneThreadRun(
+		lane: Int,
 		processNativeCalls: cpp.Callable<Void -> Void>,
 		hasPendingNativeCalls: cpp.Callable<Void -> Bool>,
 		onUnhandledException: cpp.Callable<cpp.ConstCharStar -> Void>
-	) @:privateAccess {
-		try {
-			runUserMain();
-		} catch (e: Any) {
-			onUnhandledException(Std.string(e));
-		}
+	) {
+		runEventLoop(Internal.laneLoops[lane], processNativeCalls, hasPendingNativeCalls, onUnhandledException);
+	}
 
-		// run always-alive event loop
+	/**
+		Returns a function that runs one iteration of the event loop of the calling thread: queued native calls and due haxe events are executed, then the thread waits up to `maxWait` seconds (no limit if negative) for the next event or native call
+
+		The function returns the seconds until the next scheduled haxe event, 0 if there is more work ready, or -1 if no haxe event is scheduled
+	**/
+	static function createEventLoopIteration(
+		loop: EventLoopState,
+		processNativeCalls: cpp.Callable<Void -> Void>,
+		hasPendingNativeCalls: cpp.Callable<Void -> Bool>
+	): (maxWait: Float) -> Float @:privateAccess {
 		var eventLoop = Thread.current().events;
 
 		var recycleRegular = [];
 		var recycleOneTimers = [];
-		while(Internal.mainThreadLoopActive) {
-			try {
-				// adapted from EventLoop.loop()
-				// difference is this code will break if no events are scheduled and mainThreadEndIfNoPending is true
-				// (otherwise it will wait for a wakeup() call)
-
-				// execute any queued native callbacks
-				processNativeCalls();
-
-				// drains Internal.mainThreadWaitLock()
-				// this is a problem because if wakeMainThread() is called from another thread here
-				// the main thread will stay asleep because the haxe events have been processed but not the native ones
-				var eventTickInfo = eventLoop.__progress(Sys.time(), recycleRegular, recycleOneTimers);
-
-				// since the processEvents() drains the wait lock, we must check again if new pending native calls were scheduled
-				// if so, loop again
-				if (hasPendingNativeCalls()) {
-					continue;
-				}
+		return function(maxWait: Float): Float {
+			// adapted from EventLoop.loop()
+			// difference is this code will end the loop if no events are scheduled and loop.endIfNoPending is true
+			// (otherwise it will wait for a wakeup() call)
+
+			// execute any queued native callbacks
+			processNativeCalls();
+
+			// drains loop.waitLock
+			// this is a problem because if wakeMainThread() is called from another thread here
+			// the main thread will stay asleep because the haxe events have been processed but not the native ones
+			var eventTickInfo = eventLoop.__progress(Sys.time(), recycleRegular, recycleOneTimers);
+
+			// since the processEvents() drains the wait lock, we must check again if new pending native calls were scheduled
+			// if so, loop again
+			if (hasPendingNativeCalls()) {
+				return 0;
+			}
 
-				switch (eventTickInfo.nextEventAt) {
-					case -2: // continue to next loop, assume events could have been scheduled
-					case -1:
-						if (Internal.mainThreadEndIfNoPending && !eventTickInfo.anyTime) {
-							// no events scheduled in the future and not waiting on any promises
-							break;
-						}
-						Internal.mainThreadWaitLock.wait();
-					case time:
-						var timeout = time - Sys.time();
-						Internal.mainThreadWaitLock.wait(Math.max(0, timeout));
-				}
-			} catch (e: Any) {
-				onUnhandledException(Std.string(e));
+			switch (eventTickInfo.nextEventAt) {
+				case -2: // continue to next loop, assume events could have been scheduled
+					return 0;
+				case -1:
+					if (loop.endIfNoPending && !eventTickInfo.anyTime) {
+						// no events scheduled in the future and not waiting on any promises
+						loop.active = false;
+						return -1;
+					}
+					if (maxWait < 0) {
+						loop.waitLock.wait();
+						return 0;
+					}
+					return loop.waitLock.wait(maxWait) ? 0 : -1;
+				case time:
+					var timeout = Math.max(0, time - Sys.time());
+					if (maxWait < 0 || timeout <= maxWait) {
+						loop.waitLock.wait(timeout);
+						return 0;
+					}
+					return loop.waitLock.wait(maxWait) ? 0 : Math.max(0, time - Sys.time());
 			}
 		}
-
-		// run a major collection when the thread ends
-		cpp.vm.Gc.run(true);
 	}
 	#else
 	@:noCompletion
 	static public function mainThreadInit(isMainThreadCb: cpp.Callable<Void -> Bool>) @:privateAccess {
 		Internal.isMainThreadCb = isMainThreadCb;
-		Internal.mainThreadWaitLock = EntryPoint.sleepLock;
+		Internal.mainLoop = new EventLoopState(EntryPoint.sleepLock);
+	}
+
+	/**
+		Returns a function that runs one iteration of the main event loop: queued native calls and due haxe events are executed, then the thread waits up to `maxWait` seconds (no limit if negative) for the next event or native call
+
+		The function returns the seconds until the next scheduled haxe event, 0 if there is more work ready, or -1 if no haxe event is scheduled
+	**/
+	static function createEventLoopIteration(
+		loop: EventLoopState,
+		processNativeCalls: cpp.Callable<Void -> Void>,
+		hasPendingNativeCalls: cpp.Callable<Void -> Bool>
+	): (maxWait: Float) -> Float @:privateAccess {
+		return function(maxWait: Float): Float {
+			// execute any queued native callbacks
+			processNativeCalls();
+
+			// adapted from EntryPoint.run()
+			var nextTick = EntryPoint.processEvents();
+
+			// since the processEvents() drains the wait lock, we must check again if new pending native calls were scheduled
+			// if so, loop again
+			if (hasPendingNativeCalls()) {
+				return 0;
+			}
+
+			if (nextTick < 0) {
+				if (loop.endIfNoPending) {
+					// no events scheduled in the future and not waiting on any promises
+					loop.active = false;
+					return -1;
+				}
+				if (maxWait < 0) {
+					loop.waitLock.wait();
+					return 0;
+				}
+				return loop.waitLock.wait(maxWait) ? 0 : -1;
+			} else if (nextTick > 0) {
+				if (maxWait < 0 || nextTick <= maxWait) {
+					loop.waitLock.wait(nextTick); // wait until nextTick or wakeup() call
+					return 0;
+				}
+				return loop.waitLock.wait(maxWait) ? 0 : nextTick - maxWait;
+			}
+			return 0;
+		}
 	}
+	#end
 
 	@:noCompletion
 	static public function mainThreadRun(
@@ -1771,38 +5032,83 @@ class HaxeCBridge {
 			onUnhandledException(Std.string(e));
 		}
 
-		while (Internal.mainThreadLoopActive) {
-			try {
-				// execute any queued native callbacks
-				processNativeCalls();
+		// run always-alive event loop
+		runEventLoop(Internal.mainLoop, processNativeCalls, hasPendingNativeCalls, onUnhandledException);
 
-				// adapted from EntryPoint.run()
-				var nextTick = EntryPoint.processEvents();
-				
-				// since the processEvents() drains the wait lock, we must check again if new pending native calls were scheduled
-				// if so, loop again
-				if (hasPendingNativeCalls()) {
-					continue;
-				}
+		// run a major collection when the thread ends
+		cpp.vm.Gc.run(true);
+	}
 
-				if (nextTick < 0) {
-					if (Internal.mainThreadEndIfNoPending) {
-						// no events scheduled in the future and not waiting on any promises
-						break;
-					}
-					Internal.mainThreadWaitLock.wait();
-				} else if (nextTick > 0) {
-					Internal.mainThreadWaitLock.wait(nextTick); // wait until nextTick or wakeup() call
-				}
+	static function runEventLoop(
+		loop: EventLoopState,
+		processNativeCalls: cpp.Callable<Void -> Void>,
+		hasPendingNativeCalls: cpp.Callable<Void -> Bool>,
+		onUnhandledException: cpp.Callable<cpp.ConstCharStar -> Void>
+	) {
+		var iterate = createEventLoopIteration(loop, processNativeCalls, hasPendingNativeCalls);
+		while (loop.active) {
+			try {
+				iterate(-1);
 			} catch (e: Any) {
 				onUnhandledException(Std.string(e));
 			}
 		}
+	}
 
-		// run a major collection when the thread ends
+	/**
+		Replaces `mainThreadRun()` when haxe runs inline on a host thread: runs main() and prepares the main event loop, which the host then runs with `pumpEvents()`
+	**/
+	@:noCompletion
+	static public function mainThreadStartInline(
+		processNativeCalls: cpp.Callable<Void -> Void>,
+		hasPendingNativeCalls: cpp.Callable<Void -> Bool>,
+		onUnhandledException: cpp.Callable<cpp.ConstCharStar -> Void>
+	) @:privateAccess {
+		try {
+			runUserMain();
+		} catch (e: Any) {
+			onUnhandledException(Std.string(e));
+		}
+
+		Internal.pumpIteration = createEventLoopIteration(Internal.mainLoop, processNativeCalls, hasPendingNativeCalls);
+	}
+
+	/**
+		Runs one iteration of the main event loop on the inline host thread, see `createEventLoopIteration()`
+	**/
+	@:noCompletion
+	static public function pumpEvents(maxSeconds: Float, onUnhandledException: cpp.Callable<cpp.ConstCharStar -> Void>): Float {
+		if (!Internal.mainLoop.active) {
+			return -1;
+		}
+		return try {
+			Internal.pumpIteration(Math.max(0, maxSeconds));
+		} catch (e: Any) {
+			onUnhandledException(Std.string(e));
+			0;
+		}
+	}
+
+	/**
+		Runs the main event loop on the inline host thread until it ends (it has been told to end with `endMainThread()`)
+	**/
+	@:noCompletion
+	static public function mainThreadEndInline(
+		processNativeCalls: cpp.Callable<Void -> Void>,
+		hasPendingNativeCalls: cpp.Callable<Void -> Bool>,
+		onUnhandledException: cpp.Callable<cpp.ConstCharStar -> Void>
+	) {
+		runEventLoop(Internal.mainLoop, processNativeCalls, hasPendingNativeCalls, onUnhandledException);
+		Internal.pumpIteration = null;
+
+		// run a major collection when haxe ends
 		cpp.vm.Gc.run(true);
 	}
-	#end
+
+	@:noCompletion
+	static public function isMainLoopActive(): Bool {
+		return Internal.mainLoop.active;
+	}
 
 	static public inline function retainHaxeObject(haxeObject: Dynamic): HaxeObject<{}> {
 		// need to get pointer to object
@@ -1810,41 +5116,109 @@ class HaxeCBridge {
 		// we can convert the ptr to int64
 		// https://stackoverflow.com/a/21250110
 		var ptrInt64: Int64 = untyped __cpp__('reinterpret_cast<int64_t>({0})', ptr);
-		inline retainPtr(ptrInt64, haxeObject);
+		retainPtr(ptrInt64, haxeObject);
 		return ptr;
 	}
 
 	static public inline function retainHaxeString(haxeString: String): cpp.ConstCharStar {
 		var cStrPtr: cpp.ConstCharStar = cpp.ConstCharStar.fromString(haxeString);
 		var ptrInt64: Int64 = untyped __cpp__('reinterpret_cast<int64_t>({0})', cStrPtr);
-		inline retainPtr(ptrInt64, haxeString);
+		retainPtr(ptrInt64, haxeString);
+		return cStrPtr;
+	}
+
+	/**
+		Retains a string for C and returns a pointer to its null-terminated UTF-8 bytes, the length in bytes is written to `length`
+
+		8-bit strings are returned without copying. UTF-16 strings are converted and the conversion is cached, so returning the same string again does not re-encode it
+	**/
+	static public function retainHaxeStringView(haxeString: String, length: Star<Int>): cpp.ConstCharStar {
+		if (haxeString == null) {
+			untyped __cpp__('*{0} = 0', length);
+			return null;
+		}
+
+		var isUTF16: Bool = untyped __cpp__('haxeCBridgeIsUTF16({0})', haxeString);
+		if (!isUTF16) {
+			// hxcpp stores 8-bit strings as null-terminated UTF-8 so we can point directly at the string buffer (this is the same pointer retainHaxeString() returns)
+			var cStrPtr: cpp.ConstCharStar = untyped __cpp__('{0}.raw_ptr()', haxeString);
+			untyped __cpp__('*{0} = {1}', length, haxeString.length);
+			retainPtr(untyped __cpp__('reinterpret_cast<int64_t>({0})', cStrPtr), haxeString);
+			return cStrPtr;
+		}
+
+		// the conversion cache is shared like the retain table
+		untyped __cpp__('HaxeCBridgeRetainLock lock');
+		var index: Int = untyped __cpp__('haxeCBridgeStringViewCacheIndex({0}, {1})', haxeString, Internal.stringViewCacheSize);
+		var cachedString = Internal.stringViewCacheKeys[index];
+		var utf8 = Internal.stringViewCacheValues[index];
+		var isCached: Bool = cachedString != null && untyped __cpp__('{0}.raw_ptr() == {1}.raw_ptr()', cachedString, haxeString);
+		if (!isCached) {
+			utf8 = haxe.io.Bytes.ofString(haxeString).getData();
+			// null-terminate so the view can also be used as a C string
+			utf8.push(0);
+			Internal.stringViewCacheKeys[index] = haxeString;
+			Internal.stringViewCacheValues[index] = utf8;
+		}
+
+		var cStrPtr: cpp.ConstCharStar = untyped __cpp__('(const char*) {0}->getBase()', utf8);
+		untyped __cpp__('*{0} = {1}', length, utf8.length - 1);
+		retainPtr(untyped __cpp__('reinterpret_cast<int64_t>({0})', cStrPtr), utf8);
 		return cStrPtr;
 	}
 
+	/**
+		Returns a string with the contents of `length` UTF-8 bytes at `ptr` (or up to the null terminator if `length` is negative)
+
+		Short strings are interned: if a string with the same contents was created recently it is returned rather than allocating a new string
+		Used for arguments of functions with `@internStrings`, must be called on the haxe main thread
+	**/
+	static public function internString(ptr: cpp.ConstCharStar, length: Int): String {
+		if (untyped __cpp__('{0} == nullptr', ptr)) {
+			return null;
+		}
+		if (length < 0) {
+			length = untyped __cpp__('(int) strlen({0})', ptr);
+		}
+		if (Internal.internedStrings == null) {
+			Internal.internedStrings = new haxe.ds.Vector<String>(untyped __cpp__('HaxeCBridgeInternTable::size'));
+		}
+		var slot: Int = untyped __cpp__('haxeCBridgeInternTable.find({0}, {1})', ptr, length);
+		if (slot >= 0) {
+			return Internal.internedStrings[slot];
+		}
+		var str: String = untyped __cpp__('::String::create({0}, {1})', ptr, length);
+		slot = untyped __cpp__('haxeCBridgeInternTable.insert({0}, {1})', ptr, length);
+		if (slot >= 0) {
+			Internal.internedStrings[slot] = str;
+		}
+		return str;
+	}
+
 	static private function retainPtr(ptrInt64: Int64, haxeObject: Dynamic) {
-		// check if we already have a reference to this object
-		var store = Internal.gcRetainMap.get(ptrInt64);
-		if (store == null) {
-			// if not, create a new entry
-			store = {refCount: 1, value: haxeObject};
-			Internal.gcRetainMap.set(ptrInt64, store);
-		} else {
-			// if so, increment the reference count
-			store.refCount++;
+		untyped __cpp__('HaxeCBridgeRetainLock lock');
+		// the table keeps the reference count, the value is kept alive by storing it in its slot
+		var slot: Int = untyped __cpp__('haxeCBridgeRetainTable.retain(reinterpret_cast<const void*>({0}))', ptrInt64);
+		if (slot >= 0) {
+			Internal.retainedValues[slot] = haxeObject;
 		}
 	}
 
-	static public inline function releaseHaxePtr(haxePtr: Star<cpp.Void>) {
-		var ptrInt64: Int64 = untyped __cpp__('reinterpret_cast<int64_t>({0})', haxePtr);
-		var store = Internal.gcRetainMap.get(ptrInt64);
-		if (store != null && store.refCount > 0) {
-			store.refCount--;
-			if (store.refCount <= 0) {
-				Internal.gcRetainMap.remove(ptrInt64);
-			}
+	static public function releaseHaxePtr(haxePtr: Star<cpp.Void>) {
+		untyped __cpp__('HaxeCBridgeRetainLock lock');
+		// returns the slot when the last reference is released
+		var slot: Int = untyped __cpp__('haxeCBridgeRetainTable.release({0})', haxePtr);
+		if (slot >= 0) {
+			Internal.retainedValues[slot] = null;
 		}
 	}
 
+	/** number of distinct haxe values currently retained for C **/
+	static public function retainedCount(): Int {
+		untyped __cpp__('HaxeCBridgeRetainLock lock');
+		return untyped __cpp__('haxeCBridgeRetainTable.slotCount - haxeCBridgeRetainTable.freeCount');
+	}
+
 	@:noCompletion
 	static public inline function isMainThread(): Bool {
 		return Internal.isMainThreadCb();
@@ -1853,100 +5227,100 @@ class HaxeCBridge {
 	/** not thread-safe, must be called in the haxe main thread **/
 	@:noCompletion
 	static public function endMainThread(waitOnScheduledEvents: Bool) {
-		Internal.mainThreadEndIfNoPending = true;
-		Internal.mainThreadLoopActive = Internal.mainThreadLoopActive && waitOnScheduledEvents;
-		inline wakeMainThread();
+		Internal.mainLoop.end(waitOnScheduledEvents);
 	}
 
 	/** called from _unattached_ external thread, must not allocate in hxcpp **/
 	@:noDebug
 	@:noCompletion
 	static public function wakeMainThread() {
-		inline Internal.mainThreadWaitLock.release();
+		inline Internal.mainLoop.waitLock.release();
 	}
 
+	/**
+		Allocates the event loop state of `count` lanes, called on the haxe main thread before any lane thread starts
+	**/
 	@:noCompletion
-	static macro function runUserMain() { /* implementation provided above in macro version of HaxeCBridge */ }
-
-}
-
-private class Internal {
-	public static var isMainThreadCb: cpp.Callable<Void -> Bool>;
-	public static var mainThreadWaitLock: Lock;
-	public static var mainThreadLoopActive: Bool = true;
-	public static var mainThreadEndIfNoPending: Bool = false;
-	public static final gcRetainMap = new Int64Map<{
-		refCount: Int,
-		value: Dynamic
-	}>();
-}
-
-#if (haxe_ver >= 4.3)
-typedef Int64Map<T> = Map<Int64, T>;
-#else
-/**
-	Implements an Int64 map via two Int32 maps, using the low and high parts as keys
-	we need @Aidan63's PR to land before we can use Map<Int64, Dynamic>
-	https://github.com/HaxeFoundation/hxcpp/pull/932
-**/
-abstract Int64Map<T>(Map<Int, Map<Int, T>>) {
+	static public function lanesInit(count: Int) {
+		Internal.laneLoops = new haxe.ds.Vector<EventLoopState>(count);
+	}
 
-	public function new() {
-		this = new Map<Int, Map<Int, T>>();
+	/** not thread-safe, must be called in the thread of the lane **/
+	@:noCompletion
+	static public function endLaneThread(lane: Int, waitOnScheduledEvents: Bool) {
+		Internal.laneLoops[lane].end(waitOnScheduledEvents);
 	}
 
-	public inline function set(key: Int64, value: T) {
-		var low: Int = low32(key);
-		var high: Int = high32(key);
+	/** called from _unattached_ external thread, must not allocate in hxcpp **/
+	@:noDebug
+	@:noCompletion
+	static public function wakeLane(lane: Int) {
+		Internal.laneLoops[lane].waitLock.release();
+	}
 
-		// low will vary faster and alias less, so use low as primary key
-		var highMap = this.get(low);
-		if (highMap == null) {
-			highMap = new Map<Int, T>();
-			this.set(low, highMap);
-		}
+	/**
+		Retained values are shared between threads once lane threads are running, after this the retain table is locked on access
+		Must be called on the haxe main thread before any other thread retains values
+	**/
+	@:noCompletion
+	static public function shareRetainTable() {
+		untyped __cpp__('haxeCBridgeRetainTableShared = true');
+	}
 
-		highMap.set(high, value);
+	/**
+		Enters a GC-free zone before a call to a `@gcFreeCallback` argument, see `gcFreeCall()`
+	**/
+	@:noCompletion
+	static public function enterGCFreeCallback() {
+		untyped __cpp__('haxeCBridgeInGCFreeZone = true');
+		cpp.vm.Gc.enterGCFreeZone();
 	}
 
-	public inline function get(key: Int64): Null<T> {
-		var low: Int = low32(key);
-		var high: Int = high32(key);
-		var highMap = this.get(low);
-		return (highMap != null) ? highMap.get(high): null;
+	@:noCompletion
+	static public function exitGCFreeCallback() {
+		cpp.vm.Gc.exitGCFreeZone();
+		untyped __cpp__('haxeCBridgeInGCFreeZone = false');
 	}
 
-	public inline function remove(key: Int64): Bool {
-		var low: Int = low32(key);
-		var high: Int = high32(key);
-		var highMap = this.get(low);
+	@:noCompletion
+	static macro function runUserMain() { /* implementation provided above in macro version of HaxeCBridge */ }
 
-		return if (highMap != null) {
-			var removed = highMap.remove(high);
-			var isHighMapEmpty = true;
-			for (k in highMap.keys()) {
-				isHighMapEmpty = false;
-				break;
-			}
-			// if the high map has no more keys we can dispose of it (so that we don't have empty maps left for unused low keys)
-			if (isHighMapEmpty) {
-				this.remove(low);
-			}
-			return removed;
-		} else {
-			false;
-		}
-	}
+	@:noCompletion
+	static public macro function gcFreeCall(callback: haxe.macro.Expr, args: Array<haxe.macro.Expr>) { /* implementation provided above in macro version of HaxeCBridge */ }
+
+}
+
+private class EventLoopState {
+	public final waitLock: Lock;
+	public var active: Bool = true;
+	public var endIfNoPending: Bool = false;
 
-	inline function high32(key: Int64): Int {
-		return untyped __cpp__('{0} >> 32', key);
+	public function new(waitLock: Lock) {
+		this.waitLock = waitLock;
 	}
 
-	inline function low32(key: Int64): Int {
-		return untyped __cpp__('{0} & 0xffffffff', key);
+	public function end(waitOnScheduledEvents: Bool) {
+		endIfNoPending = true;
+		active = active && waitOnScheduledEvents;
+		waitLock.release();
 	}
+}
 
+private class Internal {
+	public static var isMainThreadCb: cpp.Callable<Void -> Bool>;
+	public static var mainLoop: EventLoopState;
+	// one iteration of the main event loop when haxe runs inline on a host thread, see HaxeCBridge.pumpEvents()
+	public static var pumpIteration: Null<(maxWait: Float) -> Float>;
+	// indexed by lane, see HaxeCBridge.lanesInit()
+	public static var laneLoops: haxe.ds.Vector<EventLoopState>;
+	// retained values indexed by their HaxeCBridgeRetainTable slot
+	public static final retainedValues = new Array<Dynamic>();
+	// direct-mapped cache of the UTF-8 conversions of UTF-16 strings returned as HaxeStringView, must be a power of two
+	public static final stringViewCacheSize = 64;
+	public static final stringViewCacheKeys = new haxe.ds.Vector<String>(stringViewCacheSize);
+	public static final stringViewCacheValues = new haxe.ds.Vector<haxe.io.BytesData>(stringViewCacheSize);
+	// strings in the intern cache indexed by their HaxeCBridgeInternTable slot, created by HaxeCBridge.internString() so its size comes from HaxeCBridgeInternTable::size
+	public static var internedStrings: haxe.ds.Vector<String> = null;
 }
-#end
 
 #end
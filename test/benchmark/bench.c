@@ -0,0 +1,284 @@
+#include "haxe-bin/Bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+
+#define log(str) fprintf(stderr, "%s:%d: " str "\n", __FILE__, __LINE__)
+#define logf(fmt, ...) fprintf(stderr, "%s:%d: " fmt "\n", __FILE__, __LINE__, __VA_ARGS__)
+
+static int64_t now_ns(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (int64_t) t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+void onHaxeException(const char* info) {
+	logf("onHaxeException: \"%s\"", info);
+	exit(1);
+}
+
+/**
+ * Benchmark results
+ */
+
+typedef struct Result {
+	const char* name;
+	int threads;
+	int64_t calls;
+	double seconds;
+	int64_t* samples; // per-call latency in nanoseconds, sorted once recorded
+} Result;
+
+static FILE* output;
+static bool firstResult = true;
+static int64_t clockOverhead_ns = 0;
+
+static int compareInt64(const void* a, const void* b) {
+	int64_t x = *(const int64_t*) a;
+	int64_t y = *(const int64_t*) b;
+	return (x > y) - (x < y);
+}
+
+// nearest-rank percentile of sorted samples
+static int64_t percentile(const int64_t* sorted, int64_t n, double p) {
+	int64_t rank = (int64_t) (p * n + 0.999999);
+	if (rank < 1) rank = 1;
+	if (rank > n) rank = n;
+	return sorted[rank - 1];
+}
+
+static void record(Result* result) {
+	int64_t n = result->calls;
+	qsort(result->samples, n, sizeof(int64_t), compareInt64);
+
+	double sum = 0;
+	for (int64_t i = 0; i < n; i++) {
+		sum += result->samples[i];
+	}
+	double mean = sum / n;
+	int64_t p50 = percentile(result->samples, n, 0.50);
+	int64_t p99 = percentile(result->samples, n, 0.99);
+	int64_t p999 = percentile(result->samples, n, 0.999);
+	int64_t max = result->samples[n - 1];
+	double callsPerSecond = n / result->seconds;
+
+	logf("%-28s threads: %2d  p50: %6" PRId64 " ns  p99: %6" PRId64 " ns  p999: %7" PRId64 " ns  throughput: %.0f calls/s",
+		result->name, result->threads, p50, p99, p999, callsPerSecond);
+
+	fprintf(output,
+		"%s\n\t\t{\"name\": \"%s\", \"threads\": %d, \"calls\": %" PRId64 ", \"seconds\": %f, \"calls_per_second\": %f, "
+		"\"mean_ns\": %f, \"p50_ns\": %" PRId64 ", \"p99_ns\": %" PRId64 ", \"p999_ns\": %" PRId64 ", \"max_ns\": %" PRId64 "}",
+		firstResult ? "" : ",",
+		result->name, result->threads, n, result->seconds, callsPerSecond,
+		mean, p50, p99, p999, max
+	);
+	firstResult = false;
+}
+
+/**
+ * Single-threaded benchmarks, each call is timed individually
+ */
+
+typedef enum Benchmark {
+	SYNC_NOOP,
+	SYNC_ADD,
+	EXTERNAL_THREAD_ADD,
+	STRING_RETURN_RELEASE,
+	OBJECT_RETURN_RELEASE,
+} Benchmark;
+
+static void runCalls(Benchmark benchmark, int64_t calls, int64_t* samples) {
+	for (int64_t i = 0; i < calls; i++) {
+		int64_t start = now_ns();
+		switch (benchmark) {
+			case SYNC_NOOP:
+				Bench_noop();
+				break;
+			case SYNC_ADD: {
+				int r = Bench_add((int) i, 1);
+				assert(r == (int) i + 1);
+			} break;
+			case EXTERNAL_THREAD_ADD: {
+				int r = Bench_addExternalThread((int) i, 1);
+				assert(r == (int) i + 1);
+			} break;
+			case STRING_RETURN_RELEASE: {
+				HaxeString str = Bench_getString();
+				Bench_releaseHaxeString(str);
+			} break;
+			case OBJECT_RETURN_RELEASE: {
+				HaxeObject obj = Bench_createObject((int) i);
+				Bench_releaseHaxeObject(obj);
+			} break;
+		}
+		int64_t elapsed = now_ns() - start - clockOverhead_ns;
+		samples[i] = elapsed > 0 ? elapsed : 0;
+	}
+}
+
+static void runBenchmark(const char* name, Benchmark benchmark, int64_t calls) {
+	Result result = { name, 1, calls, 0, malloc(sizeof(int64_t) * calls) };
+	// warm up
+	runCalls(benchmark, calls / 10, result.samples);
+
+	int64_t start = now_ns();
+	runCalls(benchmark, calls, result.samples);
+	result.seconds = (now_ns() - start) / 1e9;
+
+	record(&result);
+	free(result.samples);
+}
+
+typedef struct HaxeThreadBenchmark {
+	int64_t calls;
+	int64_t* samples;
+} HaxeThreadBenchmark;
+
+// called on the haxe thread by Bench_runOnHaxeThread()
+static void runNoopOnHaxeThread(void* data) {
+	HaxeThreadBenchmark* benchmark = data;
+	runCalls(SYNC_NOOP, benchmark->calls, benchmark->samples);
+}
+
+static void runHaxeThreadBenchmark(const char* name, int64_t calls) {
+	Result result = { name, 1, calls, 0, malloc(sizeof(int64_t) * calls) };
+	HaxeThreadBenchmark benchmark = { calls / 10, result.samples };
+	// warm up
+	Bench_runOnHaxeThread(runNoopOnHaxeThread, &benchmark);
+
+	benchmark.calls = calls;
+	int64_t start = now_ns();
+	Bench_runOnHaxeThread(runNoopOnHaxeThread, &benchmark);
+	result.seconds = (now_ns() - start) / 1e9;
+
+	record(&result);
+	free(result.samples);
+}
+
+/**
+ * Multi-threaded throughput, each thread makes synchronous calls concurrently
+ */
+
+typedef struct CallerThread {
+	pthread_t handle;
+	pthread_barrier_t* barrier;
+	int64_t calls;
+	int64_t* samples;
+} CallerThread;
+
+static void* callerThreadRun(void* data) {
+	CallerThread* thread = data;
+	pthread_barrier_wait(thread->barrier);
+	runCalls(SYNC_ADD, thread->calls, thread->samples);
+	pthread_barrier_wait(thread->barrier);
+	return NULL;
+}
+
+static void runThreadedBenchmark(const char* name, int threadCount, int64_t callsPerThread) {
+	Result result = { name, threadCount, callsPerThread * threadCount, 0, malloc(sizeof(int64_t) * callsPerThread * threadCount) };
+	CallerThread* threads = malloc(sizeof(CallerThread) * threadCount);
+	pthread_barrier_t barrier;
+	pthread_barrier_init(&barrier, NULL, threadCount + 1);
+
+	for (int i = 0; i < threadCount; i++) {
+		threads[i].barrier = &barrier;
+		threads[i].calls = callsPerThread;
+		threads[i].samples = result.samples + i * callsPerThread;
+		int error = pthread_create(&threads[i].handle, NULL, callerThreadRun, &threads[i]);
+		assert(error == 0);
+	}
+
+	// all threads start and finish together
+	pthread_barrier_wait(&barrier);
+	int64_t start = now_ns();
+	pthread_barrier_wait(&barrier);
+	result.seconds = (now_ns() - start) / 1e9;
+
+	for (int i = 0; i < threadCount; i++) {
+		pthread_join(threads[i].handle, NULL);
+	}
+	pthread_barrier_destroy(&barrier);
+	free(threads);
+
+	record(&result);
+	free(result.samples);
+}
+
+static void printUsage(const char* exe) {
+	fprintf(stderr, "usage: %s [--calls N] [--threads N] [--output results.json]\n", exe);
+}
+
+int main(int argc, char** argv) {
+	int64_t calls = 1000 * 1000;
+	int maxThreads = 8;
+	const char* outputPath = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--calls") == 0 && i + 1 < argc) {
+			calls = strtoll(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			maxThreads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+			outputPath = argv[++i];
+		} else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+	if (calls < 10 || maxThreads < 1) {
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	output = outputPath != NULL ? fopen(outputPath, "w") : stdout;
+	if (output == NULL) {
+		logf("Failed to open \"%s\"", outputPath);
+		return 1;
+	}
+
+	const char* result = Bench_initializeHaxeThread(onHaxeException);
+	if (result != NULL) {
+		logf("Failed to initialize haxe: %s", result);
+		return 1;
+	}
+
+	// estimate the cost of reading the clock so it can be subtracted from samples
+	{
+		int64_t start = now_ns();
+		for (int i = 0; i < 100000; i++) {
+			now_ns();
+		}
+		clockOverhead_ns = (now_ns() - start) / 100000;
+	}
+
+	fprintf(output, "{\n\t\"clock_overhead_ns\": %" PRId64 ",\n\t\"results\": [", clockOverhead_ns);
+
+	runBenchmark("sync_noop", SYNC_NOOP, calls);
+	runBenchmark("sync_add", SYNC_ADD, calls);
+	runBenchmark("external_thread_add", EXTERNAL_THREAD_ADD, calls);
+	Bench_attachCurrentThread();
+	runBenchmark("external_thread_add_attached", EXTERNAL_THREAD_ADD, calls);
+	Bench_detachCurrentThread();
+	runHaxeThreadBenchmark("haxe_thread_noop", calls);
+	runBenchmark("string_return_release", STRING_RETURN_RELEASE, calls);
+	runBenchmark("object_return_release", OBJECT_RETURN_RELEASE, calls);
+
+	for (int threadCount = 1; threadCount <= maxThreads; threadCount++) {
+		runThreadedBenchmark("threaded_sync_add", threadCount, calls / threadCount);
+	}
+
+	fprintf(output, "\n\t]\n}\n");
+	if (output != stdout) {
+		fclose(output);
+	}
+
+	Bench_stopHaxeThreadIfRunning(false);
+
+	return 0;
+}
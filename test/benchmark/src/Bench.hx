@@ -0,0 +1,56 @@
+import cpp.Callable;
+import cpp.Star;
+
+class Bench {
+
+	static function main() {
+		BenchApi; // make sure the benchmark api is referenced so the c api is generated
+	}
+
+}
+
+/**
+	Functions called by bench.c, the bodies are trivial so the benchmarks measure the cost of the bridge
+**/
+@:build(HaxeCBridge.expose(''))
+class BenchApi {
+
+	static final string = 'benchmark string';
+
+	static public function noop(): Void {}
+
+	static public function add(a: Int, b: Int): Int {
+		return a + b;
+	}
+
+	@externalThread
+	static public function addExternalThread(a: Int, b: Int): Int {
+		return a + b;
+	}
+
+	static public function getString(): String {
+		return string;
+	}
+
+	static public function createObject(value: Int): Payload {
+		return new Payload(value);
+	}
+
+	/**
+		Executes `callback(data)` on the haxe thread, calls made from inside the callback take the same-thread fast path
+	**/
+	static public function runOnHaxeThread(callback: Callable<Star<cpp.Void> -> Void>, data: Star<cpp.Void>): Void {
+		callback(data);
+	}
+
+}
+
+class Payload {
+
+	public final value: Int;
+
+	public function new(value: Int) {
+		this.value = value;
+	}
+
+}
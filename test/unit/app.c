@@ -41,6 +41,8 @@
 #else
 	#include <time.h>
 	#include <unistd.h>
+	#include <poll.h>
+	#include <pthread.h>
 #endif
 
 #define log(str) printf("%s:%d: " str "\n", __FILE__, __LINE__)
@@ -85,6 +87,65 @@ void fnStruct(MessagePayload msg) {
 	assert(strcmp(msg.cStr, "hello") == 0);
 }
 
+// threads for tests that call haxe from several C threads at once
+#ifdef _WIN32
+	typedef HANDLE TestThread;
+	#define TEST_THREAD_FUNC DWORD WINAPI
+	#define TEST_THREAD_RET return 0
+	void startTestThread(TestThread* thread, DWORD (WINAPI *func)(void*), void* data) {
+		*thread = CreateThread(NULL, 0, func, data, 0, NULL);
+		assert(*thread != NULL);
+	}
+	void joinTestThread(TestThread thread) {
+		WaitForSingleObject(thread, INFINITE);
+		CloseHandle(thread);
+	}
+#else
+	typedef pthread_t TestThread;
+	#define TEST_THREAD_FUNC void*
+	#define TEST_THREAD_RET return NULL
+	void startTestThread(TestThread* thread, void* (*func)(void*), void* data) {
+		int error = pthread_create(thread, NULL, func, data);
+		assert(error == 0);
+	}
+	void joinTestThread(TestThread thread) {
+		pthread_join(thread, NULL);
+	}
+#endif
+
+// makes a few slow @workerThread calls, recording the most calls the pool ran at once
+TEST_THREAD_FUNC callWorkerThreadRun(void* data) {
+	int* mostConcurrentCalls = (int*) data;
+	for (int i = 0; i < 3; i++) {
+		int concurrentCalls = HaxeLib_overlapOnWorkerThread(50);
+		if (concurrentCalls > *mostConcurrentCalls) *mostConcurrentCalls = concurrentCalls;
+	}
+	TEST_THREAD_RET;
+}
+
+TEST_THREAD_FUNC collectOnAttachedThreadRun(void* data) {
+	HaxeLib_attachCurrentThread();
+	HaxeLib_Main_hxcppGcRunExternal(true);
+	HaxeLib_detachCurrentThread();
+	TEST_THREAD_RET;
+}
+
+// called in a GC-free zone on the haxe thread by HaxeLib_gcFreeBlockingCallback()
+int fnGCFreeBlocking(int i) {
+	// calls back into haxe leave the zone for their duration
+	assert(HaxeLib_add(3, 4) == 7);
+	HaxeObject map = HaxeLib_createHaxeMap();
+	HaxeLib_checkHaxeMap(map);
+	HaxeLib_releaseHaxeObject(map);
+	assert(!HaxeLib_callInExternalThread(1.0)); // @externalThread executes on this thread, which is the haxe main thread
+
+	// the collection can only complete while this thread is GC-free again, otherwise this join never returns
+	TestThread thread;
+	startTestThread(&thread, collectOnAttachedThreadRun, NULL);
+	joinTestThread(thread);
+	return i * 2;
+}
+
 double deltaTime_ns(struct timespec start, struct timespec end) {
 	return (double)(end.tv_sec - start.tv_sec) * 1.0e9 + (double)(end.tv_nsec - start.tv_nsec);
 }
@@ -92,8 +153,67 @@ double deltaTime_ms(struct timespec start, struct timespec end) {
 	return deltaTime_ns(start, end) / 1e6;
 }
 
-int main(void) {
+// haxe can only be initialized once per process so inline mode is tested by a separate run: `app --inline`
+// haxe is initialized on this thread rather than on a haxe thread and haxe events only run while we pump them
+int runInlineTests(void) {
+	log("Initializing haxe inline");
+	const char* result = HaxeLib_initializeHaxeInline(onHaxeException);
+	if (result != NULL) {
+		logf("Failed to initialize haxe inline: %s", result);
+	}
+	assert(result == NULL);
+	assert(HaxeLib_initializeHaxeInline(onHaxeException) != NULL); // already initialized
+
+	// calls from this thread execute directly, including @workerThread calls as they do on the haxe main thread
+	assert(HaxeLib_callInMainThread(123.4));
+	assert(HaxeLib_add(3, 4) == 7);
+	assert(!HaxeLib_callInWorkerThread(567.8));
+
+	// the timer loop started by main() only advances while we pump
+	int loopCount = HaxeLib_Main_getLoopCount();
+	struct timespec start;
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &start);
+	do {
+		#ifdef __linux__
+		// the event fd is readable when haxe has work, so we can wait on it instead of pumping on a timeout
+		struct pollfd eventFd = { HaxeLib_getEventFd(), POLLIN, 0 };
+		assert(eventFd.fd >= 0);
+		assert(poll(&eventFd, 1, 1000) == 1); // the timer loop is due every 100ms
+		double nextEventSeconds = HaxeLib_pumpHaxeEvents(0);
+		#else
+		double nextEventSeconds = HaxeLib_pumpHaxeEvents(0.05);
+		#endif
+		assert(nextEventSeconds >= 0); // the timer loop is always scheduled
+		clock_gettime(CLOCK_REALTIME, &now);
+	} while (deltaTime_ms(start, now) < 500);
+	logf("Timer loop count after pumping: %d", HaxeLib_Main_getLoopCount());
+	assert(HaxeLib_Main_getLoopCount() > loopCount);
+
+	// stopping from inside a haxe call (onHaxeException is called within the call) ends the loop later rather than from within the call
+	HaxeLib_Main_stopLoopingAfterTime_ms(200);
+	{
+		HaxeCBridgeTicket ticket = HaxeLib_throwExceptionWithResult_submit();
+		assert(HaxeLib_pollTicket(ticket)); // the exception completes the ticket
+		assert(HaxeLib_throwExceptionWithResult_result(ticket) == 0);
+	}
+	assert(HaxeLib_pumpHaxeEvents(0) >= 0); // the stop waits on the timer loop, which is still scheduled
+
+	// stopping outside of a pump runs the remaining events on this thread
+	HaxeLib_stopHaxeThreadIfRunning(true);
+	assert(HaxeLib_pumpHaxeEvents(0) == -1);
+
+	log("All inline tests completed successfully");
+
+	return 0;
+}
+
+int main(int argc, char** argv) {
 	log("Hello From C");
+
+	if (argc > 1 && strcmp(argv[1], "--inline") == 0) {
+		return runInlineTests();
+	}
 	
 	// we can call stop without a haxe thread, but it should do nothing
 	HaxeLib_stopHaxeThreadIfRunning(true);
@@ -111,8 +231,47 @@ int main(void) {
 
 	assert(HaxeLib_callInMainThread(123.4));
 	assert(HaxeLib_callInExternalThread(567.8));
+
+	// @workerThread: executed on the worker pool, which starts on first use
+	assert(HaxeLib_initializeWorkerThreads(2));
+	assert(!HaxeLib_initializeWorkerThreads(4)); // already started
+	assert(HaxeLib_callInWorkerThread(567.8));
+
+	// calls made from several C threads at once run on the workers in parallel (a worker with no calls left steals from the others)
+	{
+		TestThread threads[4];
+		int mostConcurrentCalls[4] = {0};
+		for (int i = 0; i < 4; i++) {
+			startTestThread(&threads[i], callWorkerThreadRun, &mostConcurrentCalls[i]);
+		}
+		int most = 0;
+		for (int i = 0; i < 4; i++) {
+			joinTestThread(threads[i]);
+			if (mostConcurrentCalls[i] > most) most = mostConcurrentCalls[i];
+		}
+		logf("-> most @workerThread calls running at once: %d", most);
+		assert(most == 2); // the pool was started with 2 workers
+	}
+
+	// @lane: executed in order on the thread of the lane, in parallel with the haxe main thread (lanes require haxe 4.2)
+	#ifdef HaxeLib_HAS_LANES
+	assert(HaxeLib_callInLane(567.8));
+	{
+		HaxeString str = HaxeLib_getLaneString();
+		assert(strcmp(str, "from the io lane") == 0);
+		HaxeLib_releaseHaxeString(str);
+	}
+	#endif
 	assert(HaxeLib_add(3, 4) == 7);
 
+	// @batch: execute many calls in a single hop to the haxe thread
+	{
+		HaxeLib_add_Args args[4] = {{1, 2}, {3, 4}, {5, 6}, {7, 8}};
+		int results[4] = {0};
+		HaxeLib_add_batch(4, args, results);
+		assert(results[0] == 3 && results[1] == 7 && results[2] == 11 && results[3] == 15);
+	}
+
 	int i = 3;
 	int* starI = &i;
 	// changes value of i to length of string, returns pointer to i
@@ -137,6 +296,10 @@ int main(void) {
 	);
 	assert(ret == fnIntString);
 
+	// @gcFreeCallback: callbacks run in a GC-free zone and may still call back into haxe
+	assert(HaxeLib_gcFreeCallbacks(fnVoid, fnStringInt) == 6);
+	assert(HaxeLib_gcFreeBlockingCallback(fnGCFreeBlocking) == 42);
+
 	// struct
 	MessagePayload inputStruct = {
 		.someFloat = 24.0,
@@ -190,6 +353,295 @@ int main(void) {
 		#endif
 	}
 
+	// @async: calls return immediately and execute in order on the haxe thread
+	{
+		char label[16];
+		for (int i = 0; i < 1000; i++) {
+			strcpy(label, "async");
+			HaxeLib_Main_asyncAdd_async(1, label);
+			// string arguments are copied, so the buffer can be reused immediately
+			strcpy(label, "overwritten");
+		}
+		assert(HaxeLib_Main_getAsyncCallSum() == 1000);
+	}
+
+	// @async with a return value: submit many calls without blocking and collect the results later
+	{
+		HaxeCBridgeTicket tickets[32];
+		for (int i = 0; i < 32; i++) {
+			tickets[i] = HaxeLib_add_submit(i, 1);
+		}
+		HaxeLib_waitTicket(tickets[31]);
+		// calls from one thread execute in order, so all earlier tickets have completed too
+		assert(HaxeLib_pollTicket(tickets[0]));
+		for (int i = 0; i < 32; i++) {
+			assert(HaxeLib_add_result(tickets[i]) == i + 1);
+		}
+
+		HaxeCBridgeTicket stringTicket = HaxeLib_createHaxeString_submit();
+		HaxeString str = HaxeLib_createHaxeString_result(stringTicket);
+		HaxeLib_checkHaxeString(str);
+		HaxeLib_releaseHaxeString(str);
+	}
+
+	#ifdef __linux__
+	// the event fd becomes readable when a ticket completes, so a host can wait on tickets and its own descriptors together
+	{
+		int eventFd = HaxeLib_getEventFd();
+		assert(eventFd >= 0);
+		uint64_t expirations;
+		while (read(eventFd, &expirations, sizeof(expirations)) > 0) {}
+
+		HaxeCBridgeTicket ticket = HaxeLib_add_submit(1, 2);
+		struct pollfd pollEventFd = { eventFd, POLLIN, 0 };
+		assert(poll(&pollEventFd, 1, 5000) == 1);
+		assert(HaxeLib_pollTicket(ticket));
+		assert(HaxeLib_add_result(ticket) == 3);
+	}
+	#endif
+
+	// releases from C threads are deferred but execute after the calls the thread made before releasing
+	{
+		int retainedBefore = HaxeLib_getRetainedCount();
+		for (int i = 0; i < 100; i++) {
+			HaxeObject map = HaxeLib_createHaxeMap();
+			HaxeLib_checkHaxeMapAfterGc_async(map);
+			HaxeLib_releaseHaxeObject(map);
+		}
+
+		// inside a transaction the releases are recorded with the calls
+		HaxeObject maps[20];
+		for (int i = 0; i < 20; i++) {
+			maps[i] = HaxeLib_createHaxeMap();
+		}
+		HaxeLib_beginTransaction();
+		for (int i = 0; i < 20; i++) {
+			HaxeLib_checkHaxeMapAfterGc_async(maps[i]);
+			HaxeLib_releaseHaxeObject(maps[i]);
+		}
+		HaxeLib_commitTransaction();
+
+		// the count is read after the queued releases have executed
+		assert(HaxeLib_getRetainedCount() == retainedBefore);
+	}
+
+	// string views carry their length and are released like strings
+	{
+		for (int i = 0; i < 100; i++) {
+			HaxeStringView view = HaxeLib_createHaxeStringView();
+			HaxeLib_Main_hxcppGcRun(true);
+			assert(view.length == strlen(view.ptr));
+			HaxeLib_checkHaxeString(view.ptr);
+			HaxeLib_releaseHaxeString(view.ptr);
+		}
+
+		HaxeStringView unicode = HaxeLib_getUnicodeStringView();
+		assert(unicode.length == strlen("h\xc3\xa9llo \xe4\xb8\x96\xe7\x95\x8c"));
+		assert(strcmp(unicode.ptr, "h\xc3\xa9llo \xe4\xb8\x96\xe7\x95\x8c") == 0);
+		// returning the same string again reuses the conversion
+		HaxeStringView unicode2 = HaxeLib_getUnicodeStringView();
+		assert(unicode2.ptr == unicode.ptr);
+		HaxeLib_releaseHaxeString(unicode.ptr);
+		HaxeLib_Main_hxcppGcRun(true);
+		assert(strcmp(unicode2.ptr, "h\xc3\xa9llo \xe4\xb8\x96\xe7\x95\x8c") == 0);
+		HaxeLib_releaseHaxeString(unicode2.ptr);
+	}
+
+	// arrays of numbers are passed without copying
+	{
+		HaxeArray_int array = HaxeLib_createHaxeIntArray(100);
+		HaxeLib_Main_hxcppGcRun(true);
+		assert(array.length == 100);
+		for (int i = 0; i < 100; i++) {
+			assert(array.data[i] == i);
+		}
+		// passing the array back gives haxe the original array
+		assert(HaxeLib_sumHaxeIntArray(array) == 4950);
+		HaxeLib_releaseHaxeObject(array.owner);
+
+		// arrays from C use the caller memory for the duration of the call
+		double values[] = {0.5, 1.5, 2.0};
+		HaxeArray_double view = { values, 3, NULL };
+		assert(HaxeLib_sumHaxeFloatArray(view) == 4.0);
+	}
+
+	// bytes are passed without copying
+	{
+		HaxeBytes bytes = HaxeLib_createHaxeBytes(1000);
+		HaxeLib_Main_hxcppGcRun(true);
+		assert(bytes.length == 1000);
+		int sum = 0;
+		for (int i = 0; i < 1000; i++) {
+			assert(bytes.data[i] == (i & 0xFF));
+			sum += bytes.data[i];
+		}
+		// passing the bytes back gives haxe the original haxe.io.Bytes
+		assert(HaxeLib_sumHaxeBytes(bytes) == sum);
+		HaxeLib_releaseHaxeObject(bytes.owner);
+
+		// bytes from C are a view of the caller memory
+		unsigned char buffer[16] = {0};
+		HaxeBytes view = { buffer, sizeof(buffer), NULL };
+		HaxeLib_fillHaxeBytes(view, 7);
+		assert(buffer[0] == 7 && buffer[15] == 7);
+		assert(HaxeLib_sumHaxeBytes(view) == 7 * 16);
+	}
+
+	// anonymous structures of numbers are passed by value
+	{
+		HaxeLib_Point p = HaxeLib_createPoint(1.5, 2.5, 7);
+		assert(p.x == 1.5 && p.y == 2.5 && p.id == 7);
+		HaxeLib_Point scaled = HaxeLib_scalePoint(p, 2.0);
+		assert(scaled.x == 3.0 && scaled.y == 5.0 && scaled.id == 7);
+	}
+
+	// views passed to haxe only read `length` bytes
+	{
+		const char* chars = "key-not-terminated";
+		HaxeStringView view = { chars, 3 };
+		assert(HaxeLib_checkStringView(view, "key"));
+
+		// repeated keys are interned so the same haxe string is reused
+		HaxeLib_internedKeyReused("key", view);
+		assert(HaxeLib_internedKeyReused("key", view));
+		char copy[] = "key";
+		assert(HaxeLib_internedKeyReused(copy, view));
+		assert(!HaxeLib_internedKeyReused("other-key", (HaxeStringView) { "other-key", 9 }));
+	}
+
+	// strings copied into a caller-provided buffer are not retained
+	{
+		char buf[64];
+		size_t length = 0;
+		assert(HaxeLib_createHaxeString_into(buf, sizeof(buf), &length));
+		assert(length == strlen("dynamically allocated string"));
+		HaxeLib_checkHaxeString(buf);
+
+		// too small: truncated but still null-terminated, the full length is reported
+		char small[8];
+		assert(!HaxeLib_createHaxeString_into(small, sizeof(small), &length));
+		assert(length == strlen("dynamically allocated string"));
+		assert(strcmp(small, "dynamic") == 0);
+
+		HaxeObject* instance = HaxeLib_Instance_new("into from C");
+		assert(HaxeLib_Instance_overrideMe_into(instance, buf, sizeof(buf), NULL));
+		assert(strcmp(buf, "into from C") == 0);
+		HaxeLib_releaseHaxeObject(instance);
+	}
+
+	// bulk release
+	{
+		HaxeObject objects[100];
+		HaxeString strings[100];
+		for (int i = 0; i < 100; i++) {
+			objects[i] = HaxeLib_createHaxeMap();
+			strings[i] = HaxeLib_createHaxeString();
+		}
+		HaxeLib_releaseHaxeObjects(objects, 100);
+		HaxeLib_releaseHaxeStrings(strings, 100);
+		HaxeLib_Main_hxcppGcRun(true);
+	}
+
+	// retain scopes: handles returned while a scope is open are released when it is popped
+	{
+		HaxeLib_pushRetainScope();
+		for (int i = 0; i < 100; i++) {
+			HaxeLib_checkHaxeMap(HaxeLib_createHaxeMap());
+			HaxeLib_checkHaxeString(HaxeLib_createHaxeString());
+		}
+		HaxeLib_pushRetainScope();
+		HaxeString inner = HaxeLib_createHaxeString();
+		HaxeLib_checkHaxeString(inner);
+		HaxeLib_popRetainScope(); // releases only `inner`
+		HaxeObject outer = HaxeLib_createHaxeMap();
+		HaxeLib_checkHaxeMap(outer);
+		HaxeLib_popRetainScope();
+		HaxeLib_Main_hxcppGcRun(true);
+
+		// outside of a scope handles must be released individually
+		HaxeObject kept = HaxeLib_createHaxeMap();
+		HaxeLib_Main_hxcppGcRun(true);
+		HaxeLib_checkHaxeMap(kept);
+		HaxeLib_releaseHaxeObject(kept);
+	}
+
+	// transactions: non-blocking calls are recorded and sent to the haxe thread on commit
+	{
+		HaxeLib_beginTransaction();
+		for (int i = 0; i < 10; i++) {
+			HaxeLib_Main_asyncAdd_async(1, "async");
+		}
+		HaxeCBridgeTicket tickets[8];
+		for (int i = 0; i < 8; i++) {
+			tickets[i] = HaxeLib_add_submit(i, 2);
+		}
+		HaxeLib_commitTransaction();
+		for (int i = 0; i < 8; i++) {
+			assert(HaxeLib_pollTicket(tickets[i]));
+			assert(HaxeLib_add_result(tickets[i]) == i + 2);
+		}
+		assert(HaxeLib_Main_getAsyncCallSum() == 1010);
+
+		// a synchronous call inside a transaction sees the effect of the calls recorded before it
+		HaxeLib_beginTransaction();
+		HaxeLib_Main_asyncAdd_async(5, "async");
+		assert(HaxeLib_Main_getAsyncCallSum() == 1015);
+		HaxeLib_Main_asyncAdd_async(5, "async");
+		HaxeLib_commitTransaction();
+		assert(HaxeLib_Main_getAsyncCallSum() == 1020);
+	}
+
+	// native call budget: the haxe thread yields to haxe events when the budget is reached, queued calls still all execute
+	{
+		HaxeCBridgeNativeCallCounters before = HaxeLib_getNativeCallCounters();
+		HaxeLib_setNativeCallBudget(8, 0.001);
+		for (int i = 0; i < 1000; i++) {
+			HaxeLib_Main_asyncAdd_async(1, "async");
+		}
+		assert(HaxeLib_Main_getAsyncCallSum() == 2020);
+		HaxeLib_setNativeCallBudget(0, 0.005);
+
+		HaxeCBridgeNativeCallCounters after = HaxeLib_getNativeCallCounters();
+		assert(after.calls - before.calls >= 1001);
+		assert(after.drains > before.drains);
+
+		// a drain that executes exactly maxCalls calls leaves nothing queued so it does not count as a budget hit
+		HaxeLib_setNativeCallBudget(1, 0);
+		before = HaxeLib_getNativeCallCounters();
+		assert(HaxeLib_Main_getAsyncCallSum() == 2020);
+		after = HaxeLib_getNativeCallCounters();
+		assert(after.countBudgetHits == before.countBudgetHits);
+		HaxeLib_setNativeCallBudget(0, 0.005);
+	}
+
+	// per-function statistics (-D HaxeCBridge.stats)
+	{
+		HaxeLib_resetBridgeStats();
+		for (int i = 0; i < 10; i++) {
+			HaxeLib_add(i, 1);
+		}
+		HaxeLib_Main_asyncAdd_async(1, "async");
+		HaxeLib_Main_getAsyncCallSum(); // wait for the async call to complete
+
+		size_t functionCount = HaxeLib_getBridgeStats(NULL, 0);
+		assert(functionCount > 0);
+		HaxeCBridgeFunctionStats* stats = malloc(sizeof(HaxeCBridgeFunctionStats) * functionCount);
+		assert(HaxeLib_getBridgeStats(stats, functionCount) == functionCount);
+		bool foundAdd = false;
+		for (size_t i = 0; i < functionCount; i++) {
+			if (strcmp(stats[i].name, "HaxeLib_add") == 0) {
+				foundAdd = true;
+				assert(stats[i].calls == 10);
+				assert(stats[i].exceptions == 0);
+			}
+			if (strcmp(stats[i].name, "HaxeLib_Main_asyncAdd") == 0) {
+				assert(stats[i].calls == 1);
+			}
+		}
+		assert(foundAdd);
+		free(stats);
+	}
+
 	// can we pass NULL for an object?
 	HaxeLib_checkNull(NULL, 0);
 
@@ -250,6 +702,14 @@ int main(void) {
 
 	HaxeLib_allocateABunchOfData();
 	HaxeLib_allocateABunchOfDataExternalThread();
+	assert(HaxeLib_allocateABunchOfDataWorkerThread(100000) == 100000);
+
+	// an attached thread makes @externalThread calls without attaching on every call, between calls it must not hold up collections
+	HaxeLib_attachCurrentThread();
+	assert(HaxeLib_callInExternalThread(567.8));
+	HaxeLib_allocateABunchOfDataExternalThread();
+	HaxeLib_allocateABunchOfData();
+	HaxeLib_detachCurrentThread();
 
 	logf("GC Memory (before major collection): %d", HaxeLib_Main_hxcppGcMemUsage());
 	log("Running major GC collection");
@@ -8,5 +8,5 @@ function timeout() { perl -e 'alarm shift; exec @ARGV' "$@"; }
 
 make -f Makefile.mac clean
 make -f Makefile.mac && {
-	timeout $TIMEOUT_SECONDS ./app
+	timeout $TIMEOUT_SECONDS ./app && timeout $TIMEOUT_SECONDS ./app --inline
 }
\ No newline at end of file
@@ -12,4 +12,5 @@ copy haxe-bin\Main-debug.dll Main-debug.dll
 copy .\haxe-bin\obj\lib\Main-debug.pdb Main-debug.pdb
 
 @REM run app.exe
-app.exe
\ No newline at end of file
+app.exe || exit /b
+app.exe --inline
\ No newline at end of file
@@ -10,6 +10,7 @@ import cpp.Star;
 import cpp.vm.Gc;
 import haxe.Timer;
 import HaxeCBridge.HaxeObject;
+import HaxeCBridge.HaxeStringView;
 
 @:buildXml('
 <section if="macos">
@@ -67,10 +68,27 @@ class Main {
 		Gc.run(major);
 	}
 
+	@externalThread static public function hxcppGcRunExternal(major: Bool) {
+		Gc.run(major);
+	}
+
 	static public function printTime() {
 		trace(Date.now().toString());
 	}
 
+	static var asyncCallSum = 0;
+
+	@async static public function asyncAdd(amount: Int, label: String) {
+		if (label != 'async') {
+			throw 'Expected label "async" (got "$label")';
+		}
+		asyncCallSum += amount;
+	}
+
+	static public function getAsyncCallSum() {
+		return asyncCallSum;
+	}
+
 }
 
 typedef CustomStarX = haxe.Timer;
@@ -82,6 +100,8 @@ typedef NonTrivialAlias = String;
 
 typedef ExampleObjectHandle = cpp.Int64;
 
+typedef Point = {x: Float, y: Float, id: Int};
+
 enum abstract IntEnumAbstract(Int) {
 	var A;
 	var B;
@@ -135,6 +155,56 @@ class PublicCApi {
 		return !HaxeCBridge.isMainThread();
 	}
 
+	/** when called externally from C this function will be executed on the worker pool, so calls from different threads run in parallel **/
+	@workerThread
+	static public function callInWorkerThread(f64: cpp.Float64): Bool {
+		return !HaxeCBridge.isMainThread();
+	}
+
+	static final workerCallMutex = new sys.thread.Mutex();
+	static var runningWorkerCalls = 0;
+	static var mostRunningWorkerCalls = 0;
+
+	/** sleeps on a worker so that calls from several C threads overlap, returns the most calls seen running at once **/
+	@workerThread
+	static public function overlapOnWorkerThread(sleepMs: Int): Int {
+		workerCallMutex.acquire();
+		runningWorkerCalls++;
+		if (runningWorkerCalls > mostRunningWorkerCalls) {
+			mostRunningWorkerCalls = runningWorkerCalls;
+		}
+		workerCallMutex.release();
+
+		Sys.sleep(sleepMs / 1000);
+
+		workerCallMutex.acquire();
+		runningWorkerCalls--;
+		var most = mostRunningWorkerCalls;
+		workerCallMutex.release();
+		return most;
+	}
+
+	@workerThread
+	static public function allocateABunchOfDataWorkerThread(n: Int): Int {
+		var array = [for(i in 0...n) ['bunch-of-data', 'on-a-worker']];
+		return array.length;
+	}
+
+	#if (haxe_ver >= 4.2)
+	/** when called externally from C this function will be executed on the thread of the "io" lane, in parallel with the haxe main thread **/
+	@lane("io")
+	static public function callInLane(f64: cpp.Float64): Bool {
+		return !HaxeCBridge.isMainThread();
+	}
+
+	@lane("io")
+	static public function getLaneString(): String {
+		return 'from the io lane';
+	}
+	#end
+
+	@batch
+	@async
 	static public function add(a: Int, b: Int): Int return a + b;
 
 	static public function starPointers(
@@ -200,6 +270,24 @@ class PublicCApi {
 		return intString;
 	}
 
+	/**
+		Callbacks run in a GC-free zone so other haxe threads can collect while they execute
+	**/
+	static public function gcFreeCallbacks(
+		@gcFreeCallback voidVoid: Callable<() -> Void>,
+		@gcFreeCallback stringInt: Callable<ConstCharStar -> Int>
+	): Int {
+		voidVoid();
+		return stringInt("hello") + stringInt(Std.string(stringInt("abc")));
+	}
+
+	/**
+		The callback calls back into haxe and blocks while another thread collects
+	**/
+	static public function gcFreeBlockingCallback(@gcFreeCallback blocking: Callable<Int -> Int>): Int {
+		return blocking(21);
+	}
+
 	static public function externStruct(v: MessagePayload, vStar: Star<MessagePayload>): MessagePayload {
 		vStar.someFloat = 12.0;
 		v.someFloat *= 2;
@@ -213,6 +301,50 @@ class PublicCApi {
 		return cpp.Pointer.ofArray(array);
 	}
 
+	static public function createHaxeIntArray(length: Int): Array<Int> {
+		return [for (i in 0...length) i];
+	}
+
+	static public function sumHaxeIntArray(array: Array<Int>): Int {
+		var sum = 0;
+		for (x in array) sum += x;
+		return sum;
+	}
+
+	static public function sumHaxeFloatArray(array: Array<Float>): Float {
+		var sum = 0.0;
+		for (x in array) sum += x;
+		return sum;
+	}
+
+	static public function createHaxeBytes(length: Int): haxe.io.Bytes {
+		var bytes = haxe.io.Bytes.alloc(length);
+		for (i in 0...length) {
+			bytes.set(i, i & 0xFF);
+		}
+		return bytes;
+	}
+
+	static public function sumHaxeBytes(bytes: haxe.io.Bytes): Int {
+		var sum = 0;
+		for (i in 0...bytes.length) sum += bytes.get(i);
+		return sum;
+	}
+
+	/** writes directly into the memory of the caller when called with C memory **/
+	static public function fillHaxeBytes(bytes: haxe.io.Bytes, value: Int): Void {
+		bytes.fill(0, bytes.length, value);
+	}
+
+	/** anonymous structures of numbers are copied to C as a plain struct **/
+	static public function createPoint(x: Float, y: Float, id: Int): Point {
+		return {x: x, y: y, id: id};
+	}
+
+	static public function scalePoint(p: Point, s: Float): Point {
+		return {x: p.x * s, y: p.y * s, id: p.id};
+	}
+
 	static public function getHaxeArrayStr(length: Star<Int>) {
 		var array = ['a', 'bbb', 'c'];
 		Native.set(length, array.length);
@@ -290,6 +422,17 @@ class PublicCApi {
 		}
 	}
 
+	@async
+	static public function checkHaxeMapAfterGc(m: Map<String, haxe.ds.List<String>>) {
+		// collect first so a map released before this call executed would be invalid
+		cpp.vm.Gc.run(true);
+		checkHaxeMap(m);
+	}
+
+	static public function getRetainedCount(): Int {
+		return HaxeCBridge.retainedCount();
+	}
+
 	static public function checkNull(m: Null<{example: String}>, f: Null<Float>) {
 		if (m != null) {
 			throw 'Expected null';
@@ -306,6 +449,7 @@ class PublicCApi {
 		}
 	}
 
+	@async
 	static public function createHaxeString() {
 		// return a dynamically allocated string to make sure the GC will collect it
 		var x = new StringBuf();
@@ -320,10 +464,41 @@ class PublicCApi {
 		}
 	}
 
+	static public function createHaxeStringView(): HaxeStringView {
+		return createHaxeString();
+	}
+
+	static public function getUnicodeStringView(): HaxeStringView {
+		// non-ascii strings are stored as UTF-16 by hxcpp's smart strings so this is converted to UTF-8
+		return 'h\u00e9llo \u4e16\u754c';
+	}
+
+	static public function checkStringView(view: HaxeStringView, expected: String): Bool {
+		return view == expected;
+	}
+
+	static var lastInternedKey: String = null;
+
+	/** returns true if `key` is the same haxe string as the one passed in the previous call **/
+	@internStrings
+	static public function internedKeyReused(key: String, view: HaxeStringView): Bool {
+		if (key != view) {
+			throw 'Expected key and view to match (got "$key" and "$view")';
+		}
+		var reused: Bool = lastInternedKey != null && untyped __cpp__('{0}.raw_ptr() == {1}.raw_ptr()', key, lastInternedKey);
+		lastInternedKey = key;
+		return reused;
+	}
+
 	static public function throwException(): Void {
 		throw 'example exception';
 	}
 
+	@async
+	static public function throwExceptionWithResult(): Int {
+		throw 'example exception';
+	}
+
 	// the following should be disallowed at compile-time
 	// static public function nonTrivialAlias(a: NonTrivialAlias, b: Star<NonTrivialAlias>): Void { } // fail because `Star<NonTrivialAlias>`
 	// static public function nonTrivialAlias2(a: Star<Map<String, String>>): Void { } // fail because `Star<Map<String, String>>`
@@ -331,7 +506,7 @@ class PublicCApi {
 	// static public function haxeCallbacks(voidVoid: () -> Void, intString: (a: Int) -> String): Void { }
 	// static public function reference(ref: cpp.Reference<Int>): Void { }
 	// static public function anon(a: {f1: Star<cpp.Void>, ?optF2: Float}): Void { }
-	// static public function array(arrayInt: Array<Int>): Void { }
+	// static public function array(arrayString: Array<String>): Void { }
 	// static public function dyn(dyn: Dynamic): Void {}
 	// static public function nullable(f: Null<Float>): Void {}
 	// static public function typeParam<T>(x: T): T return x;